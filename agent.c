@@ -0,0 +1,398 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+#include "agent.h"
+#include "netutil.h"
+#include "monitor.h"
+#include "hostaddr.h"
+#include "hostindex.h"
+#include "timeutil.h"
+#include "trace.h"
+
+// What the collector was last told about one host.
+typedef struct {
+    uint32_t addr;
+    const char* hostname; // Interned, so a new name is a new pointer
+    HostStatus status;
+    uint32_t rtt_avg_us;
+    unsigned int generation; // Last collect_changes() pass that saw the host
+} AgentHost;
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t capacity;
+} AgentBuffer;
+
+static char collector_host[256] = "";
+static char collector_port[8] = "";
+static char site_name[AGENT_SITE_MAX + 1] = "";
+static pthread_t agent_thread;
+static bool agent_started = false;
+static volatile bool agent_running = false;
+static pthread_mutex_t agent_mutex = PTHREAD_MUTEX_INITIALIZER; // Sleep between reconnects
+static pthread_cond_t agent_cond = PTHREAD_COND_INITIALIZER; // Signalled by agent_stop()
+
+// --- Agent Thread State ---
+static net_socket_t agent_socket = NET_INVALID_SOCKET;
+static AgentHost* sent_hosts = NULL;
+static int sent_count = 0;
+static int sent_capacity = 0;
+static HostIndex sent_index = {NULL, NULL, 0, 0}; // addr -> position in sent_hosts
+static unsigned int generation = 0;
+static AgentBuffer pending = {NULL, 0, 0}; // Frames not yet sent
+
+bool agent_set_collector(const char* host_port) {
+    return parse_host_port(host_port, true, collector_host, sizeof(collector_host), collector_port, sizeof(collector_port));
+}
+
+bool agent_set_site(const char* name) {
+    size_t len = strlen(name);
+    if (len == 0 || len > AGENT_SITE_MAX) return false;
+    for (const char* c = name; *c; c++) {
+        if (*c <= ' ' || *c == '@' || *c > '~') return false;
+    }
+    memcpy(site_name, name, len + 1);
+    return true;
+}
+
+bool agent_enabled(void) {
+    return collector_port[0] != '\0';
+}
+
+// --- Framing ---
+static void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    put_u16(out, (uint16_t)(value >> 16));
+    put_u16(out + 2, (uint16_t)value);
+}
+
+static bool append_frame(uint8_t type, const uint8_t* payload, size_t len) {
+    size_t needed = pending.len + AGENT_FRAME_HEADER + len;
+    if (needed > pending.capacity) {
+        size_t capacity = pending.capacity ? pending.capacity : 4096;
+        while (capacity < needed) capacity *= 2;
+        uint8_t* grown = realloc(pending.data, capacity);
+        if (!grown) return false;
+        pending.data = grown;
+        pending.capacity = capacity;
+    }
+    uint8_t* out = pending.data + pending.len;
+    out[0] = type;
+    put_u16(out + 1, (uint16_t)len);
+    if (len > 0) memcpy(out + AGENT_FRAME_HEADER, payload, len);
+    pending.len = needed;
+    return true;
+}
+
+// Writes the family and bytes of id. Returns the length, 0 if id has no address.
+static size_t put_address(uint8_t* out, uint32_t id) {
+    if (!host_id_is_ipv6(id)) {
+        out[0] = 4;
+        put_u32(out + 1, id);
+        return 5;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (!host_id_sockaddr(id, 0, &addr, &addr_len)) return 0;
+    out[0] = 6;
+    memcpy(out + 1, &((const struct sockaddr_in6*)&addr)->sin6_addr, 16); // The zone means nothing at the collector
+    return 17;
+}
+
+static bool append_hello(void) {
+    uint8_t payload[1 + AGENT_SITE_MAX];
+    size_t len = strlen(site_name);
+    payload[0] = AGENT_PROTOCOL_VERSION;
+    memcpy(payload + 1, site_name, len);
+    return append_frame(AGENT_MSG_HELLO, payload, 1 + len);
+}
+
+static bool append_host(const MonitoredHost* host) {
+    uint8_t payload[AGENT_FRAME_MAX - AGENT_FRAME_HEADER];
+    size_t len = put_address(payload, host->addr);
+    if (len == 0) return true; // Nothing the collector could show
+    payload[len++] = host->status;
+    put_u16(payload + len, host->consecutive_failures);
+    put_u32(payload + len + 2, host->rtt_avg_us);
+    len += 6;
+    size_t name_len = strlen(host->hostname);
+    if (name_len > 255) name_len = 255;
+    memcpy(payload + len, host->hostname, name_len);
+    return append_frame(AGENT_MSG_HOST, payload, len + name_len);
+}
+
+static bool append_gone(uint32_t addr) {
+    uint8_t payload[17];
+    size_t len = put_address(payload, addr);
+    return len == 0 || append_frame(AGENT_MSG_GONE, payload, len);
+}
+
+// --- Change Tracking ---
+static bool rtt_moved(uint32_t sent_us, uint32_t now_us) {
+    if (sent_us == now_us) return false;
+    if (sent_us == RTT_LOST || now_us == RTT_LOST) return true;
+    uint32_t diff = sent_us > now_us ? sent_us - now_us : now_us - sent_us;
+    return (uint64_t)diff * 100 > (uint64_t)sent_us * AGENT_RTT_CHANGE_PERCENT;
+}
+
+static void forget_sent(void) {
+    sent_count = 0;
+    host_index_clear(&sent_index);
+    pending.len = 0;
+}
+
+// Queues a HOST frame for every host that is new or changed since it was
+// last sent and a GONE frame for every host that left the table. Returns
+// false when out of memory; the caller then reconnects to resync.
+static bool collect_changes(void) {
+    bool ok = true;
+    generation++;
+    host_list_lock();
+    for (int i = 0; i < discovered_hosts_count && ok; i++) {
+        const MonitoredHost* host = &discovered_hosts[i];
+        if (host->flags & HOST_FLAG_REMOTE) continue; // A collector does not relay its agents
+
+        int slot = host_index_get(&sent_index, host->addr);
+        bool is_new = slot < 0;
+        if (is_new) {
+            if (sent_count == sent_capacity) {
+                int capacity = sent_capacity ? sent_capacity * 2 : 256;
+                AgentHost* grown = realloc(sent_hosts, capacity * sizeof(AgentHost));
+                if (!grown) {
+                    ok = false;
+                    break;
+                }
+                sent_hosts = grown;
+                sent_capacity = capacity;
+            }
+            slot = sent_count++;
+            sent_hosts[slot].addr = host->addr;
+            ok = host_index_put(&sent_index, host->addr, slot);
+        }
+
+        AgentHost* sent = &sent_hosts[slot];
+        sent->generation = generation;
+        if (!is_new && sent->status == host->status && sent->hostname == host->hostname && !rtt_moved(sent->rtt_avg_us, host->rtt_avg_us)) continue;
+        sent->status = host->status;
+        sent->hostname = host->hostname;
+        sent->rtt_avg_us = host->rtt_avg_us;
+        ok = ok && append_host(host);
+    }
+    host_list_unlock();
+
+    // Whatever this pass did not see was removed from the table
+    for (int i = 0; i < sent_count && ok;) {
+        if (sent_hosts[i].generation == generation) {
+            i++;
+            continue;
+        }
+        ok = append_gone(sent_hosts[i].addr);
+        host_index_remove(&sent_index, sent_hosts[i].addr);
+        sent_hosts[i] = sent_hosts[--sent_count];
+        if (i < sent_count) host_index_put(&sent_index, sent_hosts[i].addr, i);
+    }
+    return ok;
+}
+
+// --- Connection ---
+static void set_blocking(net_socket_t sock, bool blocking) {
+#ifdef _WIN32
+    u_long mode = blocking ? 0 : 1;
+    ioctlsocket(sock, FIONBIO, &mode);
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+#endif
+}
+
+// Connects without blocking past AGENT_CONNECT_TIMEOUT_MS, so agent_stop()
+// never waits on an unreachable collector for the OS connect timeout.
+static net_socket_t connect_with_timeout(const struct addrinfo* ai) {
+    net_socket_t sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sock == NET_INVALID_SOCKET) return sock;
+    set_blocking(sock, false);
+    if (connect(sock, ai->ai_addr, (int)ai->ai_addrlen) != 0) {
+#ifdef _WIN32
+        bool in_progress = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        bool in_progress = errno == EINPROGRESS;
+#endif
+        int err = 0;
+        socklen_t err_len = sizeof(err);
+        if (!in_progress || !net_wait(sock, true, AGENT_CONNECT_TIMEOUT_MS)
+            || getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&err, &err_len) != 0 || err != 0) {
+            net_close_socket(sock);
+            return NET_INVALID_SOCKET;
+        }
+    }
+    set_blocking(sock, true);
+
+#ifdef _WIN32
+    DWORD send_timeout = AGENT_SEND_TIMEOUT_MS;
+#else
+    struct timeval send_timeout = {AGENT_SEND_TIMEOUT_MS / 1000, (AGENT_SEND_TIMEOUT_MS % 1000) * 1000};
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&send_timeout, sizeof(send_timeout));
+    net_no_sigpipe(sock);
+    return sock;
+}
+
+static bool agent_connect(void) {
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(collector_host, collector_port, &hints, &result) != 0) return false;
+    for (struct addrinfo* ai = result; ai != NULL && agent_socket == NET_INVALID_SOCKET && agent_running; ai = ai->ai_next) {
+        agent_socket = connect_with_timeout(ai);
+    }
+    freeaddrinfo(result);
+    return agent_socket != NET_INVALID_SOCKET;
+}
+
+static void agent_disconnect(void) {
+    if (agent_socket != NET_INVALID_SOCKET) net_close_socket(agent_socket);
+    agent_socket = NET_INVALID_SOCKET;
+    forget_sent(); // The next connection starts over with the whole table
+}
+
+static bool send_pending(void) {
+    const uint8_t* data = pending.data;
+    size_t len = pending.len;
+    pending.len = 0;
+    while (len > 0) {
+        int sent = send(agent_socket, (const char*)data, (int)len, NET_SEND_FLAGS);
+        if (sent <= 0) return false;
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+// Sleeps up to delay_ms, returning early when agent_stop() is called.
+static void agent_sleep(uint64_t delay_ms) {
+    struct timespec deadline;
+    wall_clock_deadline(delay_ms, &deadline);
+    pthread_mutex_lock(&agent_mutex);
+    if (agent_running) pthread_cond_timedwait(&agent_cond, &agent_mutex, &deadline);
+    pthread_mutex_unlock(&agent_mutex);
+}
+
+static void* agent_thread_main(void* arg) {
+    (void)arg;
+    trace_name_thread("agent");
+    int backoff_s = 1;
+    bool reported_failure = false;
+    unsigned int sent_version = 0;
+    uint64_t last_send_ms = 0;
+    bool synced = false; // SYNCED sent on this connection
+
+    while (agent_running) {
+        bool ok = true;
+        if (agent_socket == NET_INVALID_SOCKET) {
+            if (!agent_connect()) {
+                if (!reported_failure) printf("Could not reach collector %s:%s; retrying in the background\n", collector_host, collector_port);
+                reported_failure = true;
+                agent_sleep((uint64_t)backoff_s * 1000);
+                backoff_s = backoff_s * 2 > AGENT_RECONNECT_MAX_S ? AGENT_RECONNECT_MAX_S : backoff_s * 2;
+                continue;
+            }
+            printf("Connected to collector %s:%s as site %s\n", collector_host, collector_port, site_name);
+            reported_failure = false;
+            backoff_s = 1;
+            sent_version = __atomic_load_n(&host_table_version, __ATOMIC_RELAXED);
+            synced = false;
+            ok = append_hello() && collect_changes();
+        } else {
+            // Bumped on every probe batch, so this is the cheap "anything at all?" test
+            unsigned int version = __atomic_load_n(&host_table_version, __ATOMIC_RELAXED);
+            if (version != sent_version) {
+                sent_version = version;
+                ok = collect_changes();
+            }
+        }
+
+        // Until the first sweep is through, a missing host may just not be found yet
+        if (ok && !synced && discovery_complete) {
+            ok = append_frame(AGENT_MSG_SYNCED, NULL, 0);
+            synced = true;
+        }
+
+        uint64_t now_ms = monotonic_ms();
+        if (ok && pending.len == 0 && now_ms - last_send_ms >= AGENT_KEEPALIVE_S * 1000ULL) ok = append_frame(AGENT_MSG_KEEPALIVE, NULL, 0);
+        if (ok && pending.len > 0) {
+            ok = send_pending();
+            last_send_ms = now_ms;
+        }
+        if (!ok) {
+            printf("Lost the connection to collector %s:%s\n", collector_host, collector_port);
+            agent_disconnect();
+            continue;
+        }
+
+        // The collector never sends, so readable means it closed the connection
+        if (net_wait(agent_socket, false, AGENT_POLL_MS)) {
+            char discard[64];
+            if (recv(agent_socket, discard, sizeof(discard), 0) <= 0) {
+                printf("Collector %s:%s closed the connection\n", collector_host, collector_port);
+                agent_disconnect();
+            }
+        }
+    }
+
+    agent_disconnect();
+    return NULL;
+}
+
+// --- Lifecycle ---
+void agent_start(void) {
+    if (!agent_enabled()) return;
+    if (site_name[0] == '\0') {
+        char name[256] = "";
+        if (gethostname(name, sizeof(name)) != 0 || name[0] == '\0') strcpy(name, "agent");
+        name[strcspn(name, ".")] = '\0'; // Short host name
+        name[AGENT_SITE_MAX] = '\0';
+        if (!agent_set_site(name)) agent_set_site("agent");
+    }
+
+    agent_running = true;
+    if (pthread_create(&agent_thread, NULL, agent_thread_main, NULL) != 0) {
+        perror("Failed to create agent thread");
+        agent_running = false;
+        return;
+    }
+    agent_started = true;
+}
+
+void agent_stop(void) {
+    if (!agent_started) return;
+    pthread_mutex_lock(&agent_mutex);
+    agent_running = false;
+    pthread_cond_broadcast(&agent_cond);
+    pthread_mutex_unlock(&agent_mutex);
+    pthread_join(agent_thread, NULL);
+    agent_started = false;
+
+    free(sent_hosts);
+    sent_hosts = NULL;
+    sent_capacity = 0;
+    host_index_free(&sent_index);
+    free(pending.data);
+    pending.data = NULL;
+    pending.capacity = 0;
+}
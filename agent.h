@@ -0,0 +1,44 @@
+#ifndef AGENT_H
+#define AGENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Agent Mode ---
+// With --agent HOST:PORT the monitor streams its host table to a collector
+// (collector.h) over one persistent TCP connection. Each connection starts
+// with the whole table; after that only hosts whose status or hostname
+// changed, or whose RTT moved by more than AGENT_RTT_CHANGE_PERCENT, are
+// sent, so an idle site costs one keepalive every AGENT_KEEPALIVE_S.
+
+#define AGENT_POLL_MS 250 // How often the agent thread looks for table changes
+#define AGENT_KEEPALIVE_S 30 // Sent when nothing else was
+#define AGENT_CONNECT_TIMEOUT_MS 3000
+#define AGENT_SEND_TIMEOUT_MS 10000 // A collector that stops reading is dropped after this
+#define AGENT_RECONNECT_MAX_S 60 // Reconnect backoff doubles up to this
+#define AGENT_RTT_CHANGE_PERCENT 25 // RTT moves smaller than this ride along with other changes
+#define AGENT_SITE_MAX 16 // Longest site name; the collector shows hosts as addr@site
+
+// --- Wire Format ---
+// Frames are [type:1][payload length:2][payload], integers big-endian.
+// Addresses are [family:1 (4 or 6)][4 or 16 bytes]. Strings fill the rest
+// of the payload and are not terminated.
+#define AGENT_PROTOCOL_VERSION 1
+#define AGENT_FRAME_HEADER 3
+#define AGENT_MSG_HELLO 1     // version:1, site name
+#define AGENT_MSG_HOST 2      // address, status:1, failures:2, rtt_avg_us:4, hostname (at most 255 bytes)
+#define AGENT_MSG_GONE 3      // address
+#define AGENT_MSG_SYNCED 4    // Empty, once the first sweep is done: hosts not sent since HELLO are gone
+#define AGENT_MSG_KEEPALIVE 5 // Empty
+#define AGENT_FRAME_MAX (AGENT_FRAME_HEADER + 17 + 1 + 2 + 4 + 255)
+
+bool agent_set_collector(const char* host_port); // --agent HOST:PORT
+bool agent_set_site(const char* name); // --site NAME; the local host name by default
+bool agent_enabled(void);
+
+// Starts the agent thread; it connects, and reconnects, on its own. Called
+// by monitor_start(). Does nothing unless --agent was given.
+void agent_start(void);
+void agent_stop(void);
+
+#endif
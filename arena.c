@@ -0,0 +1,81 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_CHUNK_SIZE 65536 // Bytes per chunk; larger requests get a chunk of their own
+#define ARENA_ALIGN 16 // Enough for any type the monitor allocates
+
+struct ArenaChunk {
+    ArenaChunk* next;
+    size_t used;
+    size_t size;
+    unsigned char data[];
+};
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Bytes needed from chunk->used on for a size byte allocation, alignment included.
+static size_t fit(const ArenaChunk* chunk, size_t size) {
+    uintptr_t start = (uintptr_t)(chunk->data + chunk->used);
+    return (size_t)(align_up(start) - start) + size;
+}
+
+static ArenaChunk* add_chunk(Arena* arena, size_t size) {
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) return NULL;
+    chunk->next = arena->chunks;
+    chunk->used = 0;
+    chunk->size = size;
+    arena->chunks = chunk;
+    return chunk;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (size == 0) size = 1; // Distinct pointers, like malloc
+    ArenaChunk* chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < fit(chunk, size)) {
+        size_t wanted = size + ARENA_ALIGN;
+        chunk = add_chunk(arena, wanted > ARENA_CHUNK_SIZE ? wanted : ARENA_CHUNK_SIZE);
+        if (!chunk) return NULL;
+    }
+    chunk->used += fit(chunk, size) - size;
+    void* block = chunk->data + chunk->used;
+    chunk->used += size;
+    return block;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+    void* block = arena_alloc(arena, count * size);
+    if (block) memset(block, 0, count * size);
+    return block;
+}
+
+void arena_reset(Arena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    if (!chunk) return;
+    if (!chunk->next) {
+        chunk->used = 0;
+        return;
+    }
+
+    // Several chunks: the round outgrew the head, so replace them all with one
+    size_t total = 0;
+    for (ArenaChunk* c = chunk; c; c = c->next) total += c->size;
+    arena_free(arena);
+    add_chunk(arena, total); // On failure the next alloc starts from scratch
+}
+
+void arena_free(Arena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
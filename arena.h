@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// --- Scratch Arena ---
+// Bump allocator for state that lives exactly as long as one probe batch or
+// one sweep. An allocation is a pointer bump and never moves; arena_reset()
+// releases everything at once and folds the chunks into a single one as
+// large as the high-water mark, so a steady workload stops calling malloc
+// after its first round. Not thread-safe; each arena has one owner at a time.
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk* chunks; // Newest first; only the head has free space
+} Arena;
+
+// Returns size bytes aligned for any type, or NULL if the arena could not grow.
+void* arena_alloc(Arena* arena, size_t size);
+// Like arena_alloc(), zeroed.
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+
+// Forgets every allocation, keeping one chunk that fits them all.
+void arena_reset(Arena* arena);
+
+void arena_free(Arena* arena);
+
+#endif
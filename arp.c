@@ -0,0 +1,177 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe_backend.h"
+
+// --- ARP Backend ---
+// Broadcasts an ARP request per target out of the local interface whose
+// subnet contains it and matches replies by sender address. Hosts answer ARP
+// even when they firewall every port and drop ICMP, but only on the local
+// segment. Linux only: it needs an AF_PACKET socket and CAP_NET_RAW.
+
+#ifdef __linux__
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <netpacket/packet.h>
+#include <net/ethernet.h>
+#include <sys/ioctl.h>
+
+#include "hostaddr.h"
+#include "hostindex.h"
+
+#define ARP_MAX_INTERFACES 16
+#define ARP_PACKET_LEN 28
+
+typedef struct {
+    int ifindex;
+    uint32_t addr; // Host byte order
+    uint32_t mask;
+    uint8_t mac[6];
+} ArpInterface;
+
+typedef struct {
+    probe_socket_t sock;
+    ArpInterface interfaces[ARP_MAX_INTERFACES];
+    int interface_count;
+    HostIndex pending; // Sender address -> target index
+} ArpState;
+
+// Lists the up, non-loopback Ethernet interfaces with an IPv4 address.
+static int arp_find_interfaces(probe_socket_t sock, ArpInterface* out, int max) {
+    struct ifaddrs *ifaddr, *ifa;
+    if (getifaddrs(&ifaddr) == -1) return 0;
+
+    int count = 0;
+    for (ifa = ifaddr; ifa != NULL && count < max; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET || ifa->ifa_netmask == NULL) continue;
+        if (!(ifa->ifa_flags & IFF_UP) || (ifa->ifa_flags & (IFF_LOOPBACK | IFF_NOARP))) continue;
+
+        struct ifreq req;
+        memset(&req, 0, sizeof(req));
+        strncpy(req.ifr_name, ifa->ifa_name, sizeof(req.ifr_name) - 1);
+        if (ioctl(sock, SIOCGIFHWADDR, &req) < 0 || req.ifr_hwaddr.sa_family != ARPHRD_ETHER) continue;
+
+        ArpInterface* iface = &out[count];
+        iface->ifindex = (int)if_nametoindex(ifa->ifa_name);
+        if (iface->ifindex == 0) continue;
+        iface->addr = ntohl(((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr);
+        iface->mask = ntohl(((struct sockaddr_in*)ifa->ifa_netmask)->sin_addr.s_addr);
+        memcpy(iface->mac, req.ifr_hwaddr.sa_data, 6);
+        count++;
+    }
+    freeifaddrs(ifaddr);
+    return count;
+}
+
+static probe_socket_t arp_open(void) {
+    probe_socket_t sock = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_ARP));
+    if (sock == PROBE_INVALID_SOCKET) return sock;
+    int buffer_size = PROBE_RCVBUF_BYTES;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    if (!probe_set_nonblocking(sock)) {
+        close(sock);
+        return PROBE_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+static void arp_put_addr(uint8_t* out, uint32_t addr) {
+    out[0] = (uint8_t)(addr >> 24);
+    out[1] = (uint8_t)(addr >> 16);
+    out[2] = (uint8_t)(addr >> 8);
+    out[3] = (uint8_t)addr;
+}
+
+static PacketSendResult arp_send(void* state, const ProbeTarget* target, int index) {
+    ArpState* arp = (ArpState*)state;
+    if (host_id_is_ipv6(target->addr)) return PACKET_FAILED; // Neighbor discovery, not ARP
+    const ArpInterface* iface = NULL;
+    for (int i = 0; i < arp->interface_count; i++) {
+        if (target->addr == arp->interfaces[i].addr) return PACKET_ANSWERED; // Kernel never answers itself
+        if ((target->addr & arp->interfaces[i].mask) == (arp->interfaces[i].addr & arp->interfaces[i].mask)) {
+            iface = &arp->interfaces[i];
+            break;
+        }
+    }
+    if (!iface) return PACKET_FAILED; // Not on a local segment; a later method has to reach it
+
+    uint8_t packet[ARP_PACKET_LEN];
+    packet[0] = 0; packet[1] = ARPHRD_ETHER;              // Hardware type
+    packet[2] = ETH_P_IP >> 8; packet[3] = ETH_P_IP & 0xFF; // Protocol type
+    packet[4] = 6; packet[5] = 4;                         // Address lengths
+    packet[6] = 0; packet[7] = ARPOP_REQUEST;
+    memcpy(packet + 8, iface->mac, 6);
+    arp_put_addr(packet + 14, iface->addr);
+    memset(packet + 18, 0, 6);
+    arp_put_addr(packet + 24, target->addr);
+
+    struct sockaddr_ll dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sll_family = AF_PACKET;
+    dest.sll_protocol = htons(ETH_P_ARP);
+    dest.sll_ifindex = iface->ifindex;
+    dest.sll_halen = 6;
+    memset(dest.sll_addr, 0xFF, 6);
+
+    if (sendto(arp->sock, packet, sizeof(packet), 0, (struct sockaddr*)&dest, sizeof(dest)) < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) ? PACKET_BLOCKED : PACKET_FAILED;
+    }
+    host_index_put(&arp->pending, target->addr, index);
+    return PACKET_SENT;
+}
+
+static int arp_receive(void* state, const ProbeTarget* targets, int count, ProbeOutcome* outcome) {
+    (void)targets;
+    (void)outcome;
+    ArpState* arp = (ArpState*)state;
+    uint8_t packet[PROBE_PACKET_MAX];
+    ssize_t len = recv(arp->sock, packet, sizeof(packet), 0);
+    if (len < 0) return PACKET_DRAINED;
+    if (len < ARP_PACKET_LEN || packet[7] != ARPOP_REPLY || packet[4] != 6 || packet[5] != 4) return PACKET_NO_MATCH;
+
+    uint32_t sender = (uint32_t)packet[14] << 24 | (uint32_t)packet[15] << 16 | (uint32_t)packet[16] << 8 | packet[17];
+    int index = host_index_get(&arp->pending, sender);
+    return (index >= 0 && index < count) ? index : PACKET_NO_MATCH;
+}
+
+int arp_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    if (!options || !options->on_result) return -1;
+
+    ArpState arp;
+    memset(&arp, 0, sizeof(arp));
+    arp.sock = arp_open();
+    if (arp.sock == PROBE_INVALID_SOCKET) return -1;
+    arp.interface_count = arp_find_interfaces(arp.sock, arp.interfaces, ARP_MAX_INTERFACES);
+
+    PacketBackend backend = {arp.sock, &arp, arp_send, arp_receive};
+    int sent = probe_packet_batch(&backend, targets, count, options);
+    host_index_free(&arp.pending);
+    close(arp.sock);
+    return sent;
+}
+
+bool arp_available(void) {
+    probe_socket_t sock = arp_open();
+    if (sock == PROBE_INVALID_SOCKET) return false;
+    close(sock);
+    return true;
+}
+
+#else // ARP needs raw link-layer access, which only the Linux build implements
+
+int arp_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    (void)targets;
+    (void)count;
+    (void)options;
+    return -1;
+}
+
+bool arp_available(void) {
+    return false;
+}
+
+#endif
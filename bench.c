@@ -0,0 +1,511 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#endif
+
+#include "monitor.h"
+#include "options.h"
+#include "notify.h"
+#include "probe.h"
+#include "timeutil.h"
+#include "trace.h"
+
+#ifdef NETMON_FIXED_PORTS
+#error "The benchmark picks its own ports; build it without a fixed-port PROFILE"
+#endif
+
+// --- Scan Benchmark ---
+// Runs the real discovery sweep and monitoring loop against a simulated
+// network of loopback listeners on 127.1.0.0 upward, then writes one JSON
+// object with the results so runs can be compared (make bench).
+//
+// Every simulated host has a closed port probed before its open one. Hosts
+// are split into three kinds:
+//   open    accepts on the open port for the whole run
+//   drop    accepts during the sweep; once monitoring starts it stops
+//           accepting, its backlog fills and further SYNs go unanswered
+//   closed  no listener at all, so every probe is refused
+// Loopback handshakes complete inside the kernel, so per-host latency cannot
+// be injected here; drops exercise the timeout path instead, which is what
+// dominates real sweeps.
+
+#define BENCH_BASE_ADDR 0x7F010000u // 127.1.0.0
+#define BENCH_DEFAULT_HOSTS 1024
+#define BENCH_DEFAULT_OPEN 60     // Percent of hosts
+#define BENCH_DEFAULT_DROP 10     // Percent of hosts
+#define BENCH_DEFAULT_DURATION 10 // Seconds of monitoring after the sweep
+#define BENCH_DEFAULT_PORT 18080  // Open port; the closed one is the next port up
+#define BENCH_SWEEP_LIMIT_S 300   // Give up on a sweep that takes longer
+#define BENCH_FRAME_MS 16         // Simulated render thread rate
+#define BENCH_SAMPLE_MS 5         // fd and thread count sampling rate
+#define BENCH_DROP_BACKLOG 1      // Connections a dropping listener queues before SYNs are lost
+
+typedef enum {
+    SIM_OPEN,
+    SIM_DROP,
+    SIM_CLOSED
+} SimHostKind;
+
+typedef struct {
+    int hosts;
+    int open_percent;
+    int drop_percent;
+    int duration_s;
+    int port;
+    const char* out_path;
+} BenchConfig;
+
+typedef struct {
+#ifdef _WIN32
+    SOCKET* listeners;
+    WSAPOLLFD* pollfds;
+#else
+    int* listeners;
+    struct pollfd* pollfds;
+#endif
+    SimHostKind* kinds;
+    int count;
+    volatile bool dropping; // Drop hosts have stopped accepting
+} SimNetwork;
+
+typedef struct {
+    uint32_t* stall_us; // Wait for host_list_mutex, one per frame
+    int frames;
+    int capacity;
+} RenderStats;
+
+static volatile bool bench_running = true;
+static SimNetwork sim;
+static RenderStats render_stats;
+static int peak_fds = -1;
+static int peak_threads = -1;
+static int peak_connects = 0;
+
+// --- Helpers ---
+static void bench_sleep_ms(int ms) {
+#ifdef _WIN32
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of values, which is sorted in place.
+static uint32_t percentile(uint32_t* values, int count, int percent) {
+    if (count == 0) return 0;
+    qsort(values, count, sizeof(uint32_t), compare_u32);
+    int rank = (int)(((int64_t)count * percent + 99) / 100);
+    if (rank < 1) rank = 1;
+    return values[rank - 1];
+}
+
+// Spreads the kinds evenly over the address range instead of in blocks.
+static SimHostKind kind_for_host(int index, const BenchConfig* config) {
+    int slot = (int)(((int64_t)index * 37) % 100);
+    if (slot < config->open_percent) return SIM_OPEN;
+    if (slot < config->open_percent + config->drop_percent) return SIM_DROP;
+    return SIM_CLOSED;
+}
+
+// --- Simulated Network ---
+static bool sim_listen(uint32_t addr, int port, int backlog, int* slot) {
+#ifdef _WIN32
+    SOCKET sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET) return false;
+#else
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return false;
+#endif
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons((uint16_t)port);
+    local.sin_addr.s_addr = htonl(addr);
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) != 0 || listen(sock, backlog) != 0) {
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+        return false;
+    }
+    sim.listeners[*slot] = sock;
+    sim.pollfds[*slot].fd = sock;
+    sim.pollfds[*slot].events = POLLIN;
+    (*slot)++;
+    return true;
+}
+
+static bool sim_network_start(const BenchConfig* config) {
+    sim.listeners = malloc(config->hosts * sizeof(*sim.listeners));
+    sim.pollfds = calloc(config->hosts, sizeof(*sim.pollfds));
+    sim.kinds = malloc(config->hosts * sizeof(SimHostKind));
+    if (!sim.listeners || !sim.pollfds || !sim.kinds) return false;
+
+    for (int i = 0; i < config->hosts; i++) {
+        SimHostKind kind = kind_for_host(i, config);
+        if (kind == SIM_CLOSED) continue;
+        sim.kinds[sim.count] = kind;
+        int backlog = (kind == SIM_DROP) ? BENCH_DROP_BACKLOG : SOMAXCONN;
+        if (!sim_listen(BENCH_BASE_ADDR + (uint32_t)i, config->port, backlog, &sim.count)) {
+            printf("Could not listen on 127.1.%d.%d:%d.\n", (i >> 8) & 0xFF, i & 0xFF, config->port);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Accepts and closes every connection to a listener that is still answering.
+static void* sim_accept_main(void* arg) {
+    (void)arg;
+    bool dropping = false;
+    while (bench_running) {
+        if (sim.dropping && !dropping) {
+            // Never accepted from now on, so the backlog fills up
+            for (int i = 0; i < sim.count; i++) {
+                if (sim.kinds[i] == SIM_DROP) sim.pollfds[i].events = 0;
+            }
+            dropping = true;
+        }
+#ifdef _WIN32
+        int ready = WSAPoll(sim.pollfds, (ULONG)sim.count, 50);
+#else
+        int ready = poll(sim.pollfds, (nfds_t)sim.count, 50);
+#endif
+        for (int i = 0; i < sim.count && ready > 0; i++) {
+            if (!(sim.pollfds[i].revents & POLLIN)) continue;
+            ready--;
+#ifdef _WIN32
+            SOCKET client = accept(sim.listeners[i], NULL, NULL);
+            if (client != INVALID_SOCKET) closesocket(client);
+#else
+            int client = accept(sim.listeners[i], NULL, NULL);
+            if (client >= 0) close(client);
+#endif
+        }
+    }
+    return NULL;
+}
+
+static void sim_network_stop(void) {
+    for (int i = 0; i < sim.count; i++) {
+#ifdef _WIN32
+        closesocket(sim.listeners[i]);
+#else
+        close(sim.listeners[i]);
+#endif
+    }
+    free(sim.listeners);
+    free(sim.pollfds);
+    free(sim.kinds);
+}
+
+// --- Samplers ---
+// Open descriptors and threads of this process, or -1 where unsupported.
+static int count_open_fds(void) {
+#ifdef __linux__
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count - 1; // Not the one opendir() holds
+#else
+    return -1;
+#endif
+}
+
+static int count_threads(void) {
+#ifdef __linux__
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return -1;
+    char line[128];
+    int threads = -1;
+    while (fgets(line, sizeof(line), status)) {
+        if (sscanf(line, "Threads: %d", &threads) == 1) break;
+    }
+    fclose(status);
+    return threads;
+#else
+    return -1;
+#endif
+}
+
+static void* sampler_main(void* arg) {
+    (void)arg;
+    while (bench_running) {
+        int fds = count_open_fds();
+        int threads = count_threads();
+        int connects = probe_connects_in_flight();
+        if (fds > peak_fds) peak_fds = fds;
+        if (threads > peak_threads) peak_threads = threads;
+        if (connects > peak_connects) peak_connects = connects;
+        bench_sleep_ms(BENCH_SAMPLE_MS);
+    }
+    return NULL;
+}
+
+// Stands in for the GUI: takes the host list lock once a frame and walks the
+// table, recording how long each frame was blocked before it could.
+static void* render_main(void* arg) {
+    (void)arg;
+    while (bench_running) {
+        uint64_t start_us = monotonic_us();
+        host_list_lock();
+        uint32_t stall_us = (uint32_t)(monotonic_us() - start_us);
+        volatile int down = 0;
+        for (int i = 0; i < discovered_hosts_count; i++) {
+            if (discovered_hosts[i].status == STATUS_DOWN) down++;
+        }
+        host_list_unlock();
+
+        if (render_stats.frames == render_stats.capacity) {
+            int capacity = render_stats.capacity ? render_stats.capacity * 2 : 1024;
+            uint32_t* grown = realloc(render_stats.stall_us, capacity * sizeof(uint32_t));
+            if (grown) {
+                render_stats.stall_us = grown;
+                render_stats.capacity = capacity;
+            }
+        }
+        if (render_stats.frames < render_stats.capacity) render_stats.stall_us[render_stats.frames++] = stall_us;
+        bench_sleep_ms(BENCH_FRAME_MS);
+    }
+    return NULL;
+}
+
+// --- Command Line ---
+static void print_bench_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --hosts N           Simulated hosts on 127.1.0.0 upward (default: %d)\n", BENCH_DEFAULT_HOSTS);
+    printf("  --open PERCENT      Hosts that accept on the open port (default: %d)\n", BENCH_DEFAULT_OPEN);
+    printf("  --drop PERCENT      Hosts that stop answering once monitoring starts (default: %d)\n", BENCH_DEFAULT_DROP);
+    printf("  --duration SECONDS  Monitoring time after the sweep (default: %d)\n", BENCH_DEFAULT_DURATION);
+    printf("  --interval SECONDS  Probe interval per host (default: 1)\n");
+    printf("  --threads N         Discovery threads (default: one per core)\n");
+    printf("  --concurrency N     Connects kept in flight (default: %d)\n", DEFAULT_PROBE_CONCURRENCY);
+    printf("  --port N            Open port; N+1 is probed first and always refused (default: %d)\n", BENCH_DEFAULT_PORT);
+    printf("  --out FILE          Write the JSON results to FILE instead of stdout\n");
+}
+
+static bool parse_bench_int(int argc, char* argv[], int* i, int min, int max, int* out) {
+    if (*i + 1 >= argc) {
+        printf("Missing value for %s\n", argv[*i]);
+        return false;
+    }
+    char* end;
+    long value = strtol(argv[*i + 1], &end, 10);
+    if (*end != '\0' || value < min || value > max) {
+        printf("Invalid value for %s. Expected %d-%d\n", argv[*i], min, max);
+        return false;
+    }
+    *out = (int)value;
+    (*i)++;
+    return true;
+}
+
+static bool parse_bench_arguments(int argc, char* argv[], BenchConfig* config) {
+    int interval_s = 1;
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "--hosts") == 0) ok = parse_bench_int(argc, argv, &i, 1, 65536, &config->hosts);
+        else if (strcmp(argv[i], "--open") == 0) ok = parse_bench_int(argc, argv, &i, 0, 100, &config->open_percent);
+        else if (strcmp(argv[i], "--drop") == 0) ok = parse_bench_int(argc, argv, &i, 0, 100, &config->drop_percent);
+        else if (strcmp(argv[i], "--duration") == 0) ok = parse_bench_int(argc, argv, &i, 0, 3600, &config->duration_s);
+        else if (strcmp(argv[i], "--interval") == 0) ok = parse_bench_int(argc, argv, &i, 1, 3600, &interval_s);
+        else if (strcmp(argv[i], "--threads") == 0) ok = parse_bench_int(argc, argv, &i, 1, MAX_DISCOVERY_THREADS, &discovery_threads);
+        else if (strcmp(argv[i], "--concurrency") == 0) ok = parse_bench_int(argc, argv, &i, 1, 65536, &probe_concurrency);
+        else if (strcmp(argv[i], "--port") == 0) ok = parse_bench_int(argc, argv, &i, 1, 65534, &config->port);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) config->out_path = argv[++i];
+        else {
+            print_bench_usage(argv[0]);
+            return false;
+        }
+        if (!ok) return false;
+    }
+    if (config->open_percent + config->drop_percent > 100) {
+        printf("--open and --drop add up to more than 100%%\n");
+        return false;
+    }
+    monitor_interval_ms = interval_s * 1000;
+    return true;
+}
+
+// Raises the descriptor limit for the listeners on top of what the scanner asks for.
+static bool reserve_descriptors(int listeners) {
+#ifndef _WIN32
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return true;
+    int concurrency = probe_concurrency > 0 ? probe_concurrency : DEFAULT_PROBE_CONCURRENCY;
+    rlim_t wanted = (rlim_t)listeners + (rlim_t)concurrency + FD_RESERVE;
+    if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= wanted) return true;
+    if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < wanted) {
+        printf("Need %d open files but the hard limit is %d; use fewer --hosts.\n", (int)wanted, (int)limit.rlim_max);
+        return false;
+    }
+    limit.rlim_cur = wanted;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+#else
+    (void)listeners;
+    return true;
+#endif
+}
+
+// --- Main ---
+int main(int argc, char* argv[]) {
+    BenchConfig config = {BENCH_DEFAULT_HOSTS, BENCH_DEFAULT_OPEN, BENCH_DEFAULT_DROP, BENCH_DEFAULT_DURATION, BENCH_DEFAULT_PORT, NULL};
+    if (!parse_bench_arguments(argc, argv, &config)) return 1;
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return 1;
+#endif
+
+    // The scanner sees a plain TCP sweep of the simulated block
+    int prefix = 32;
+    while (prefix > 16 && (1 << (32 - prefix)) < config.hosts) prefix--;
+    target_spec_add_cidr(&scan_targets, BENCH_BASE_ADDR, prefix);
+    target_spec_describe(&scan_targets, active_subnet, sizeof(active_subnet));
+    default_ports.ports[0] = (uint16_t)(config.port + 1);
+    default_ports.ports[1] = (uint16_t)config.port;
+    default_ports.count = 2;
+    probe_methods[0] = PROBE_METHOD_TCP;
+    probe_method_count = 1;
+    rediscover_interval_s = 0;
+    monitor_jitter_percent = 0;
+
+    if (!reserve_descriptors(config.hosts) || !sim_network_start(&config)) {
+        sim_network_stop();
+        return 1;
+    }
+    configure_scan_limits();
+    notify_start();
+
+    pthread_t accept_thread, sampler_thread, render_thread;
+    pthread_create(&accept_thread, NULL, sim_accept_main, NULL);
+    pthread_create(&sampler_thread, NULL, sampler_main, NULL);
+    pthread_create(&render_thread, NULL, render_main, NULL);
+
+    uint64_t start_us = monotonic_us();
+    if (!monitor_start()) {
+        bench_running = false;
+        pthread_join(accept_thread, NULL);
+        pthread_join(sampler_thread, NULL);
+        pthread_join(render_thread, NULL);
+        sim_network_stop();
+        return 1;
+    }
+    while (!__atomic_load_n(&discovery_complete, __ATOMIC_ACQUIRE) && monotonic_us() - start_us < BENCH_SWEEP_LIMIT_S * 1000000ull) {
+        bench_sleep_ms(1);
+    }
+    bool swept = __atomic_load_n(&discovery_complete, __ATOMIC_ACQUIRE);
+    uint64_t sweep_us = __atomic_load_n(&monitor_stats.discovery_us, __ATOMIC_RELAXED);
+    uint64_t sweep_probes = probe_total_launched();
+    int found = 0;
+    host_list_lock();
+    for (int i = 0; i < discovered_hosts_count; i++) {
+        if (!(discovered_hosts[i].flags & HOST_FLAG_PINNED)) found++;
+    }
+    host_list_unlock();
+
+    sim.dropping = true;
+    uint64_t monitor_start_us = monotonic_us();
+    if (swept) bench_sleep_ms(config.duration_s * 1000);
+    uint64_t monitor_us = monotonic_us() - monitor_start_us;
+    uint64_t monitor_probes = probe_total_launched() - sweep_probes;
+
+    // Gather before stopping, while the table still holds every host
+    host_list_lock();
+    uint32_t* rtts = malloc((discovered_hosts_count + 1) * RTT_HISTORY * sizeof(uint32_t));
+    int rtt_count = 0, down = 0;
+    for (int i = 0; rtts && i < discovered_hosts_count; i++) {
+        const MonitoredHost* host = &discovered_hosts[i];
+        if (host->flags & HOST_FLAG_PINNED) continue;
+        if (host->status == STATUS_DOWN) down++;
+        const RttHistory* history = &host_detail(host->detail)->rtt;
+        for (int s = 0; s < history->count; s++) rtts[rtt_count++] = rtt_history_at(history, s);
+    }
+    host_list_unlock();
+    uint64_t lock_wait_us = __atomic_load_n(&monitor_stats.lock_wait_us, __ATOMIC_RELAXED);
+
+    monitor_stop();
+    bench_running = false;
+    pthread_join(accept_thread, NULL);
+    pthread_join(sampler_thread, NULL);
+    pthread_join(render_thread, NULL);
+    trace_finish(); // Histograms of the run in a TRACE=1 build
+
+    uint32_t stall_max = 0;
+    uint64_t stall_total = 0;
+    for (int i = 0; i < render_stats.frames; i++) {
+        if (render_stats.stall_us[i] > stall_max) stall_max = render_stats.stall_us[i];
+        stall_total += render_stats.stall_us[i];
+    }
+    uint32_t stall_p99 = percentile(render_stats.stall_us, render_stats.frames, 99);
+    uint32_t rtt_p50 = rtts ? percentile(rtts, rtt_count, 50) : 0;
+    uint32_t rtt_p99 = rtts ? percentile(rtts, rtt_count, 99) : 0;
+    double sweep_s = sweep_us / 1e6;
+    double monitor_s = monitor_us / 1e6;
+
+    FILE* out = config.out_path ? fopen(config.out_path, "w") : stdout;
+    if (!out) {
+        printf("Cannot write %s\n", config.out_path);
+        out = stdout;
+    }
+    fprintf(out, "{\"hosts\":%d,\"open_percent\":%d,\"drop_percent\":%d,\"threads\":%d,\"concurrency\":%d,"
+                 "\"sweep_complete\":%s,\"sweep_ms\":%.1f,\"sweep_probes\":%llu,\"sweep_probes_per_s\":%.0f,\"hosts_found\":%d,"
+                 "\"monitor_s\":%.2f,\"monitor_probes\":%llu,\"monitor_probes_per_s\":%.0f,\"hosts_down\":%d,"
+                 "\"rtt_samples\":%d,\"rtt_p50_us\":%u,\"rtt_p99_us\":%u,"
+                 "\"peak_fds\":%d,\"peak_threads\":%d,\"peak_connects\":%d,\"lock_wait_us\":%llu,"
+                 "\"render_frames\":%d,\"render_stall_max_us\":%u,\"render_stall_p99_us\":%u,\"render_stall_total_us\":%llu}\n",
+            config.hosts, config.open_percent, config.drop_percent, discovery_threads, probe_concurrency,
+            swept ? "true" : "false", sweep_us / 1000.0, (unsigned long long)sweep_probes, sweep_s > 0 ? sweep_probes / sweep_s : 0.0, found,
+            monitor_s, (unsigned long long)monitor_probes, monitor_s > 0 ? monitor_probes / monitor_s : 0.0, down,
+            rtt_count, rtt_p50, rtt_p99,
+            peak_fds, peak_threads, peak_connects, (unsigned long long)lock_wait_us,
+            render_stats.frames, stall_max, stall_p99, (unsigned long long)stall_total);
+    if (out != stdout) {
+        fclose(out);
+        printf("Results written to %s\n", config.out_path);
+    }
+
+    free(rtts);
+    free(render_stats.stall_us);
+    notify_shutdown();
+    monitor_cleanup();
+    sim_network_stop();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return swept ? 0 : 1;
+}
@@ -0,0 +1,467 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
+
+#include "collector.h"
+#include "netutil.h"
+#include "agent.h"
+#include "monitor.h"
+#include "hostaddr.h"
+#include "hostindex.h"
+#include "timeutil.h"
+#include "trace.h"
+
+#define REMOTE_INITIAL_SLOTS 256
+
+typedef struct {
+    uint8_t family; // 4 or 6
+    uint8_t bytes[16];
+} RemoteAddr;
+
+typedef struct {
+    char name[AGENT_SITE_MAX + 1];
+    RemoteAddr* hosts; // hosts[n] is the address of remote_id(site, n)
+    uint32_t count;
+    uint32_t capacity;
+    HostIndex known; // Ids of this site now in the host table (collector thread only)
+    int connection; // Index into connections, -1 while no agent for the site is connected
+} CollectorSite;
+
+typedef struct {
+    net_socket_t sock;
+    int site; // -1 until HELLO
+    bool synced; // SYNCED arrived; until then seen collects the ids reported
+    HostIndex seen;
+    uint8_t buffer[COLLECTOR_BUFFER];
+    size_t len;
+    uint64_t heard_ms; // Last time anything arrived
+    char peer[HOST_ADDR_STRLEN];
+} CollectorConnection;
+
+static char listen_host[256] = "";
+static char listen_port[8] = "";
+static net_socket_t listen_socket = NET_INVALID_SOCKET;
+static pthread_t collector_thread;
+static bool collector_started = false;
+static volatile bool collector_running = false;
+static CollectorConnection connections[COLLECTOR_MAX_AGENTS];
+
+// --- Remote Address Table (guarded by remote_mutex) ---
+// Sites and their hosts are append-only, so a remote id keeps naming the
+// same address for the whole run, across agent reconnects. slots is an
+// open-addressing set of ids keyed by site and address, 0 marking a free slot.
+static pthread_mutex_t remote_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CollectorSite* sites = NULL;
+static int site_count = 0;
+static uint32_t* remote_slots = NULL;
+static size_t remote_slot_count = 0; // Power of two
+static size_t remote_used = 0;
+
+bool collector_set_listen(const char* spec) {
+    return parse_host_port(spec, false, listen_host, sizeof(listen_host), listen_port, sizeof(listen_port));
+}
+
+bool collector_enabled(void) {
+    return listen_port[0] != '\0';
+}
+
+static uint32_t remote_id(int site, uint32_t index) {
+    return HOST_ID_REMOTE_BASE | ((uint32_t)site << 16) | index;
+}
+
+static const RemoteAddr* remote_addr_of(uint32_t id) {
+    int site = (int)((id - HOST_ID_REMOTE_BASE) >> 16);
+    uint32_t index = id & 0xFFFF;
+    if (site >= site_count || index >= sites[site].count) return NULL;
+    return &sites[site].hosts[index];
+}
+
+static size_t remote_hash(int site, const RemoteAddr* addr) {
+    uint32_t hash = 2166136261u ^ (uint32_t)site; // FNV-1a
+    hash = (hash ^ addr->family) * 16777619u;
+    for (int i = 0; i < 16; i++) hash = (hash ^ addr->bytes[i]) * 16777619u;
+    return hash;
+}
+
+static bool remote_grow_slots(void) {
+    size_t new_count = remote_slot_count ? remote_slot_count * 2 : REMOTE_INITIAL_SLOTS;
+    uint32_t* new_slots = calloc(new_count, sizeof(uint32_t));
+    if (!new_slots) return false;
+    for (size_t i = 0; i < remote_slot_count; i++) {
+        uint32_t id = remote_slots[i];
+        if (id == 0) continue;
+        size_t slot = remote_hash((int)((id - HOST_ID_REMOTE_BASE) >> 16), remote_addr_of(id)) & (new_count - 1);
+        while (new_slots[slot] != 0) slot = (slot + 1) & (new_count - 1);
+        new_slots[slot] = id;
+    }
+    free(remote_slots);
+    remote_slots = new_slots;
+    remote_slot_count = new_count;
+    return true;
+}
+
+// Returns the id of addr at site, adding it when add is set. 0 when unknown
+// or full.
+static uint32_t remote_host_id(int site, const RemoteAddr* addr, bool add) {
+    pthread_mutex_lock(&remote_mutex);
+    uint32_t id = 0;
+    if (!HASH_HAS_ROOM(remote_used, remote_slot_count) && !remote_grow_slots()) {
+        pthread_mutex_unlock(&remote_mutex);
+        return 0;
+    }
+    size_t slot = remote_hash(site, addr) & (remote_slot_count - 1);
+    while (remote_slots[slot] != 0) {
+        uint32_t candidate = remote_slots[slot];
+        if ((int)((candidate - HOST_ID_REMOTE_BASE) >> 16) == site && memcmp(remote_addr_of(candidate), addr, sizeof(*addr)) == 0) {
+            id = candidate;
+            break;
+        }
+        slot = (slot + 1) & (remote_slot_count - 1);
+    }
+
+    CollectorSite* owner = &sites[site];
+    if (id == 0 && add && owner->count < COLLECTOR_HOSTS_PER_SITE) {
+        if (owner->count == owner->capacity) {
+            uint32_t capacity = owner->capacity ? owner->capacity * 2 : 64;
+            RemoteAddr* hosts = realloc(owner->hosts, capacity * sizeof(RemoteAddr));
+            if (hosts) {
+                owner->hosts = hosts;
+                owner->capacity = capacity;
+            }
+        }
+        if (owner->count < owner->capacity) {
+            owner->hosts[owner->count] = *addr;
+            id = remote_id(site, owner->count++);
+            remote_slots[slot] = id;
+            remote_used++;
+        }
+    }
+    pthread_mutex_unlock(&remote_mutex);
+    return id;
+}
+
+// Returns the slot of the site called name, adding it if new; -1 when full.
+static int find_site(const char* name) {
+    for (int i = 0; i < site_count; i++) {
+        if (strcmp(sites[i].name, name) == 0) return i;
+    }
+    if (site_count >= COLLECTOR_MAX_SITES) return -1;
+
+    pthread_mutex_lock(&remote_mutex);
+    CollectorSite* grown = realloc(sites, (site_count + 1) * sizeof(CollectorSite));
+    if (grown) {
+        sites = grown;
+        CollectorSite* site = &sites[site_count++];
+        memset(site, 0, sizeof(*site));
+        strcpy(site->name, name);
+        site->connection = -1;
+    }
+    pthread_mutex_unlock(&remote_mutex);
+    return grown ? site_count - 1 : -1;
+}
+
+// Shows a remote id as addr@site.
+static void format_remote_addr(uint32_t id, char* buffer, size_t size) {
+    RemoteAddr addr;
+    char site[AGENT_SITE_MAX + 1] = "";
+    pthread_mutex_lock(&remote_mutex);
+    const RemoteAddr* found = remote_addr_of(id);
+    if (found) {
+        addr = *found;
+        strcpy(site, sites[(id - HOST_ID_REMOTE_BASE) >> 16].name);
+    }
+    pthread_mutex_unlock(&remote_mutex);
+    if (!found) return;
+
+    char text[INET6_ADDRSTRLEN];
+    if (!inet_ntop(addr.family == 4 ? AF_INET : AF_INET6, addr.bytes, text, sizeof(text))) return;
+    snprintf(buffer, size, "%s@%s", text, site);
+}
+
+// --- Frames ---
+static uint16_t get_u16(const uint8_t* in) {
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return ((uint32_t)get_u16(in) << 16) | get_u16(in + 2);
+}
+
+// Reads an address. Returns the bytes used, 0 if malformed.
+static size_t get_address(const uint8_t* in, size_t len, RemoteAddr* out) {
+    memset(out, 0, sizeof(*out));
+    if (len < 1) return 0;
+    size_t addr_len = in[0] == 4 ? 4 : (in[0] == 6 ? 16 : 0);
+    if (addr_len == 0 || len < 1 + addr_len) return 0;
+    out->family = in[0];
+    memcpy(out->bytes, in + 1, addr_len);
+    return 1 + addr_len;
+}
+
+static void drop_stale_hosts(CollectorSite* site, const HostIndex* seen) {
+    uint32_t* stale = malloc((site->known.count ? site->known.count : 1) * sizeof(uint32_t));
+    if (!stale) return;
+    size_t count = 0;
+    for (size_t i = 0; i < site->known.capacity; i++) {
+        uint32_t id = site->known.keys[i];
+        if (id != 0 && host_index_get(seen, id) < 0) stale[count++] = id;
+    }
+    for (size_t i = 0; i < count; i++) {
+        monitor_remove_remote(stale[i]);
+        host_index_remove(&site->known, stale[i]);
+    }
+    if (count > 0) printf("Site %s no longer reports %lu hosts; dropped them\n", site->name, (unsigned long)count);
+    free(stale);
+}
+
+static bool handle_hello(CollectorConnection* connection, int index, const uint8_t* payload, size_t len) {
+    if (connection->site >= 0 || len < 2 || len - 1 > AGENT_SITE_MAX) return false;
+    if (payload[0] != AGENT_PROTOCOL_VERSION) {
+        printf("Agent at %s speaks protocol %d, expected %d\n", connection->peer, payload[0], AGENT_PROTOCOL_VERSION);
+        return false;
+    }
+    char name[AGENT_SITE_MAX + 1];
+    memcpy(name, payload + 1, len - 1);
+    name[len - 1] = '\0';
+    for (const char* c = name; *c; c++) {
+        if (*c <= ' ' || *c == '@' || *c > '~') return false;
+    }
+
+    int site = find_site(name);
+    if (site < 0) {
+        printf("Too many sites; refusing agent %s at %s\n", name, connection->peer);
+        return false;
+    }
+    int previous = sites[site].connection;
+    if (previous >= 0) {
+        // Most likely the same agent reconnecting before its old connection timed out
+        printf("Agent %s reconnected from %s\n", name, connection->peer);
+        net_close_socket(connections[previous].sock);
+        connections[previous].sock = NET_INVALID_SOCKET;
+        host_index_free(&connections[previous].seen);
+    } else {
+        printf("Agent %s connected from %s\n", name, connection->peer);
+    }
+    sites[site].connection = index;
+    connection->site = site;
+    connection->synced = false;
+    host_index_clear(&connection->seen);
+    return true;
+}
+
+static bool handle_host(CollectorConnection* connection, const uint8_t* payload, size_t len) {
+    RemoteAddr addr;
+    size_t used = get_address(payload, len, &addr);
+    if (connection->site < 0 || used == 0 || len < used + 7 || payload[used] > STATUS_DOWN) return false;
+    HostStatus status = (HostStatus)payload[used];
+    int failures = get_u16(payload + used + 1);
+    uint32_t rtt_avg_us = get_u32(payload + used + 3);
+    char hostname[256];
+    size_t name_len = len - used - 7;
+    if (name_len >= sizeof(hostname)) name_len = sizeof(hostname) - 1;
+    memcpy(hostname, payload + used + 7, name_len);
+    hostname[name_len] = '\0';
+
+    CollectorSite* site = &sites[connection->site];
+    uint32_t id = remote_host_id(connection->site, &addr, true);
+    if (id == 0) return true; // Site is full; keep the rest of the stream
+    monitor_merge_remote(id, hostname[0] ? hostname : "N/A", status, failures, rtt_avg_us);
+    host_index_put(&site->known, id, 0);
+    if (!connection->synced) host_index_put(&connection->seen, id, 0);
+    return true;
+}
+
+static bool handle_gone(CollectorConnection* connection, const uint8_t* payload, size_t len) {
+    RemoteAddr addr;
+    if (connection->site < 0 || get_address(payload, len, &addr) == 0) return false;
+    CollectorSite* site = &sites[connection->site];
+    uint32_t id = remote_host_id(connection->site, &addr, false);
+    if (id == 0 || host_index_get(&site->known, id) < 0) return true;
+    monitor_remove_remote(id);
+    host_index_remove(&site->known, id);
+    host_index_remove(&connection->seen, id);
+    return true;
+}
+
+// Applies one frame. False drops the connection.
+static bool handle_frame(CollectorConnection* connection, int index, uint8_t type, const uint8_t* payload, size_t len) {
+    switch (type) {
+        case AGENT_MSG_HELLO: return handle_hello(connection, index, payload, len);
+        case AGENT_MSG_HOST: return handle_host(connection, payload, len);
+        case AGENT_MSG_GONE: return handle_gone(connection, payload, len);
+        case AGENT_MSG_SYNCED:
+            if (connection->site < 0) return false;
+            // Hosts the agent had before it reconnected but no longer reports
+            drop_stale_hosts(&sites[connection->site], &connection->seen);
+            connection->synced = true;
+            host_index_free(&connection->seen);
+            return true;
+        default: return connection->site >= 0; // KEEPALIVE, and types from newer agents
+    }
+}
+
+// --- Connections ---
+static void close_connection(int index) {
+    CollectorConnection* connection = &connections[index];
+    if (connection->sock == NET_INVALID_SOCKET) return;
+    net_close_socket(connection->sock);
+    connection->sock = NET_INVALID_SOCKET;
+    host_index_free(&connection->seen);
+    if (connection->site >= 0 && sites[connection->site].connection == index) {
+        sites[connection->site].connection = -1;
+        printf("Agent %s disconnected; its hosts keep their last reported status\n", sites[connection->site].name);
+    }
+}
+
+static void accept_agent(void) {
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    net_socket_t sock = accept(listen_socket, (struct sockaddr*)&peer, &peer_len);
+    if (sock == NET_INVALID_SOCKET) return;
+
+    int index = -1;
+    for (int i = 0; i < COLLECTOR_MAX_AGENTS && index < 0; i++) {
+        if (connections[i].sock == NET_INVALID_SOCKET) index = i;
+    }
+    if (index < 0) {
+        net_close_socket(sock);
+        printf("Already serving %d agents; refusing another\n", COLLECTOR_MAX_AGENTS);
+        return;
+    }
+
+    CollectorConnection* connection = &connections[index];
+    connection->sock = sock;
+    connection->site = -1;
+    connection->synced = false;
+    connection->len = 0;
+    connection->heard_ms = monotonic_ms();
+    memset(&connection->seen, 0, sizeof(connection->seen));
+    if (getnameinfo((struct sockaddr*)&peer, peer_len, connection->peer, sizeof(connection->peer), NULL, 0, NI_NUMERICHOST) != 0) {
+        strcpy(connection->peer, "?");
+    }
+}
+
+// Reads what arrived and applies every complete frame in the buffer.
+static void read_agent(int index) {
+    CollectorConnection* connection = &connections[index];
+    int got = recv(connection->sock, (char*)connection->buffer + connection->len, (int)(sizeof(connection->buffer) - connection->len), 0);
+    if (got <= 0) {
+        close_connection(index);
+        return;
+    }
+    connection->len += (size_t)got;
+    connection->heard_ms = monotonic_ms();
+
+    size_t offset = 0;
+    while (connection->len - offset >= AGENT_FRAME_HEADER) {
+        const uint8_t* frame = connection->buffer + offset;
+        size_t payload_len = get_u16(frame + 1);
+        if (payload_len > AGENT_FRAME_MAX - AGENT_FRAME_HEADER) {
+            printf("Malformed frame from agent at %s; dropping it\n", connection->peer);
+            close_connection(index);
+            return;
+        }
+        if (connection->len - offset < AGENT_FRAME_HEADER + payload_len) break;
+        if (!handle_frame(connection, index, frame[0], frame + AGENT_FRAME_HEADER, payload_len)) {
+            printf("Unexpected frame from agent at %s; dropping it\n", connection->peer);
+            close_connection(index);
+            return;
+        }
+        offset += AGENT_FRAME_HEADER + payload_len;
+    }
+    memmove(connection->buffer, connection->buffer + offset, connection->len - offset);
+    connection->len -= offset;
+}
+
+static void* collector_thread_main(void* arg) {
+    (void)arg;
+    trace_name_thread("collector");
+    // The listener, then one entry per open connection
+    net_pollfd_t pollfds[COLLECTOR_MAX_AGENTS + 1];
+    int polled[COLLECTOR_MAX_AGENTS + 1]; // Connection index of each entry after the listener
+    while (collector_running) {
+        pollfds[0].fd = listen_socket;
+        pollfds[0].events = POLLIN;
+        pollfds[0].revents = 0;
+        int count = 1;
+        for (int i = 0; i < COLLECTOR_MAX_AGENTS; i++) {
+            if (connections[i].sock == NET_INVALID_SOCKET) continue;
+            pollfds[count].fd = connections[i].sock;
+            pollfds[count].events = POLLIN;
+            pollfds[count].revents = 0;
+            polled[count++] = i;
+        }
+        if (net_poll(pollfds, count, COLLECTOR_POLL_MS) < 0) continue;
+
+        uint64_t now_ms = monotonic_ms();
+        for (int p = 1; p < count; p++) {
+            int i = polled[p];
+            if (connections[i].sock != pollfds[p].fd) continue; // Closed while reading another agent
+            if (pollfds[p].revents) {
+                read_agent(i);
+            } else if (now_ms - connections[i].heard_ms >= COLLECTOR_IDLE_TIMEOUT_S * 1000ULL) {
+                printf("Agent at %s went quiet; closing its connection\n", connections[i].peer);
+                close_connection(i);
+            }
+        }
+        if (pollfds[0].revents & POLLIN) accept_agent();
+    }
+    for (int i = 0; i < COLLECTOR_MAX_AGENTS; i++) close_connection(i);
+    return NULL;
+}
+
+// --- Lifecycle ---
+bool collector_start(void) {
+    if (!collector_enabled()) return true;
+    for (int i = 0; i < COLLECTOR_MAX_AGENTS; i++) connections[i].sock = NET_INVALID_SOCKET;
+
+    listen_socket = open_listener(listen_host, listen_port, 16, "agents");
+    if (listen_socket == NET_INVALID_SOCKET) return false;
+
+    remote_addr_formatter = format_remote_addr;
+    collector_running = true;
+    if (pthread_create(&collector_thread, NULL, collector_thread_main, NULL) != 0) {
+        perror("Failed to create collector thread");
+        collector_running = false;
+        net_close_socket(listen_socket);
+        listen_socket = NET_INVALID_SOCKET;
+        return false;
+    }
+    collector_started = true;
+    printf("Collecting from agents on %s:%s\n", listen_host[0] ? listen_host : "*", listen_port);
+    return true;
+}
+
+// Leaves the remote address table alone: the host table may still format
+// remote ids until monitor_cleanup() calls collector_cleanup().
+void collector_stop(void) {
+    if (!collector_started) return;
+    collector_running = false;
+    pthread_join(collector_thread, NULL);
+    collector_started = false;
+    net_close_socket(listen_socket);
+    listen_socket = NET_INVALID_SOCKET;
+    for (int i = 0; i < site_count; i++) host_index_free(&sites[i].known);
+}
+
+void collector_cleanup(void) {
+    pthread_mutex_lock(&remote_mutex);
+    remote_addr_formatter = NULL;
+    for (int i = 0; i < site_count; i++) {
+        free(sites[i].hosts);
+        host_index_free(&sites[i].known);
+    }
+    free(sites);
+    free(remote_slots);
+    sites = NULL;
+    site_count = 0;
+    remote_slots = NULL;
+    remote_slot_count = remote_used = 0;
+    pthread_mutex_unlock(&remote_mutex);
+}
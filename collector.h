@@ -0,0 +1,30 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <stdbool.h>
+
+// --- Collector Mode ---
+// With --collect [HOST:]PORT the monitor accepts agents (agent.h) on one
+// thread and merges what they report into its own host table, so a single
+// window or daemon covers every site. Agent hosts are shown as addr@site,
+// get remote ids (hostaddr.h) and are never probed from here; the
+// collector's own targets are monitored as usual beside them.
+
+#define COLLECTOR_MAX_AGENTS 63 // Agents connected at once
+#define COLLECTOR_MAX_SITES 4096 // Site names per run: remote ids have 12 bits for the site
+#define COLLECTOR_HOSTS_PER_SITE 65536 // and 16 for the host
+#define COLLECTOR_POLL_MS 200 // How often the collector thread checks for shutdown
+#define COLLECTOR_BUFFER 4096 // Per-agent receive buffer, several frames long
+#define COLLECTOR_IDLE_TIMEOUT_S 90 // Agents silent this long (three keepalives) are dropped
+
+bool collector_set_listen(const char* spec); // "PORT" (all interfaces) or "HOST:PORT"
+bool collector_enabled(void);
+
+// Binds the listener and starts the collector thread. Called by
+// monitor_start(). Returns true without doing anything when disabled.
+bool collector_start(void);
+void collector_stop(void);
+// Frees the remote address table once nothing formats remote ids any more.
+void collector_cleanup(void);
+
+#endif
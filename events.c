@@ -0,0 +1,192 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "events.h"
+#include "notify.h"
+#include "timeutil.h"
+
+#define DISPATCH_BATCH 64 // Changes handed to the sinks per call
+
+AlertHook alert_hook = NULL;
+
+// --- Ring (one producer at a time, one consumer) ---
+// head is written only by the consumer and tail only by the producer holding
+// producer_mutex; acquire/release on them orders the slot contents.
+static StatusChange ring[EVENT_QUEUE_CAPACITY];
+static unsigned int ring_head = 0; // Next slot to read
+static unsigned int ring_tail = 0; // Next slot to write
+
+static pthread_mutex_t producer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Sleeping and waking only; the ring is never written under wake_mutex.
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t consumer_cond = PTHREAD_COND_INITIALIZER; // Data arrived or stopping
+static pthread_cond_t producer_cond = PTHREAD_COND_INITIALIZER; // Space freed
+static int consumer_sleeping = 0;
+static int producer_waiting = 0;
+
+static pthread_t dispatch_thread;
+static bool dispatch_started = false;
+static volatile bool dispatch_running = false;
+
+static unsigned int ring_used(void) {
+    return __atomic_load_n(&ring_tail, __ATOMIC_SEQ_CST) - __atomic_load_n(&ring_head, __ATOMIC_SEQ_CST);
+}
+
+void events_publish(const StatusChange* changes, int count) {
+    if (count <= 0) return;
+    if (!dispatch_running) {
+        // Nothing is draining the ring (not started, or already stopped): deliver inline
+        notify_status_changes(changes, count);
+        if (status_change_hook) status_change_hook(changes, count);
+        return;
+    }
+
+    pthread_mutex_lock(&producer_mutex);
+    for (int i = 0; i < count; i++) {
+        unsigned int tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+        if (tail - __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE) == EVENT_QUEUE_CAPACITY) {
+            // Full: wait for the consumer rather than lose a log line
+            pthread_mutex_lock(&wake_mutex);
+            __atomic_store_n(&producer_waiting, 1, __ATOMIC_SEQ_CST);
+            while (ring_used() == EVENT_QUEUE_CAPACITY && dispatch_running) {
+                pthread_cond_signal(&consumer_cond);
+                pthread_cond_wait(&producer_cond, &wake_mutex);
+            }
+            __atomic_store_n(&producer_waiting, 0, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&wake_mutex);
+            if (ring_used() == EVENT_QUEUE_CAPACITY) break; // Stopped while waiting
+        }
+        ring[tail % EVENT_QUEUE_CAPACITY] = changes[i];
+        __atomic_store_n(&ring_tail, tail + 1, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&producer_mutex);
+
+    // Only pay for the mutex when the consumer is actually asleep
+    if (__atomic_load_n(&consumer_sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&wake_mutex);
+        pthread_cond_signal(&consumer_cond);
+        pthread_mutex_unlock(&wake_mutex);
+    }
+}
+
+static int ring_pop(StatusChange* out, int max) {
+    unsigned int head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    unsigned int available = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE) - head;
+    int n = (available < (unsigned int)max) ? (int)available : max;
+    for (int i = 0; i < n; i++) out[i] = ring[(head + i) % EVENT_QUEUE_CAPACITY];
+    __atomic_store_n(&ring_head, head + n, __ATOMIC_SEQ_CST);
+
+    if (n > 0 && __atomic_load_n(&producer_waiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&wake_mutex);
+        pthread_cond_signal(&producer_cond);
+        pthread_mutex_unlock(&wake_mutex);
+    }
+    return n;
+}
+
+// Sleeps until a producer pushes, the dispatcher is stopped, or wait_ms
+// passes (wait_ms < 0 waits without a timeout).
+static void wait_for_events(int64_t wait_ms) {
+    pthread_mutex_lock(&wake_mutex);
+    __atomic_store_n(&consumer_sleeping, 1, __ATOMIC_SEQ_CST);
+    if (ring_used() == 0 && dispatch_running) {
+        if (wait_ms < 0) {
+            pthread_cond_wait(&consumer_cond, &wake_mutex);
+        } else {
+            struct timespec deadline;
+            wall_clock_deadline((uint64_t)wait_ms, &deadline);
+            pthread_cond_timedwait(&consumer_cond, &wake_mutex, &deadline);
+        }
+    }
+    __atomic_store_n(&consumer_sleeping, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&wake_mutex);
+}
+
+// --- Dispatch ---
+static void* dispatch_thread_main(void* arg) {
+    (void)arg;
+    StatusChange batch[DISPATCH_BATCH];
+    AlertSummary pending;
+    memset(&pending, 0, sizeof(pending));
+    uint64_t window_start_ms = 0; // First DOWN of the pending alert
+    uint64_t last_alert_ms = 0;
+    bool alerted = false;
+
+    for (;;) {
+        int n = ring_pop(batch, DISPATCH_BATCH);
+        if (n > 0) {
+            // Logs and the UDP sink see every change, uncoalesced and in order
+            notify_status_changes(batch, n);
+            if (status_change_hook) status_change_hook(batch, n);
+            for (int i = 0; i < n; i++) {
+                if (batch[i].new_status == STATUS_DOWN) {
+                    if (pending.went_down++ == 0) {
+                        pending.first = batch[i];
+                        window_start_ms = monotonic_ms();
+                    }
+                } else if (batch[i].old_status == STATUS_DOWN && pending.went_down > 0) {
+                    pending.recovered++;
+                }
+            }
+            continue; // Drain fully before deciding on an alert
+        }
+
+        if (!dispatch_running) break; // Drained; a pending alert is dropped at shutdown
+
+        int64_t wait_ms = -1;
+        if (pending.went_down > 0) {
+            uint64_t due = window_start_ms + ALERT_COALESCE_MS;
+            if (alerted && last_alert_ms + ALERT_MIN_INTERVAL_MS > due) due = last_alert_ms + ALERT_MIN_INTERVAL_MS;
+            uint64_t now = monotonic_ms();
+            if (now >= due) {
+                if (alert_hook) alert_hook(&pending);
+                memset(&pending, 0, sizeof(pending));
+                last_alert_ms = now;
+                alerted = true;
+                continue;
+            }
+            wait_ms = (int64_t)(due - now);
+        }
+        wait_for_events(wait_ms);
+    }
+    return NULL;
+}
+
+bool events_start(void) {
+    dispatch_running = true;
+    if (pthread_create(&dispatch_thread, NULL, dispatch_thread_main, NULL) != 0) {
+        perror("Failed to create event dispatch thread");
+        dispatch_running = false; // events_publish() falls back to inline delivery
+        return false;
+    }
+    dispatch_started = true;
+    return true;
+}
+
+void events_stop(void) {
+    if (!dispatch_started) return;
+    pthread_mutex_lock(&wake_mutex);
+    dispatch_running = false;
+    pthread_cond_broadcast(&consumer_cond);
+    pthread_cond_broadcast(&producer_cond);
+    pthread_mutex_unlock(&wake_mutex);
+    pthread_join(dispatch_thread, NULL);
+    dispatch_started = false;
+}
+
+void alert_summary_describe(const AlertSummary* summary, char* buffer, size_t size) {
+    if (summary->went_down == 1) {
+        const char* name = summary->first.hostname;
+        if (name[0] == '\0' || strcmp(name, HOSTNAME_RESOLVING) == 0 || strcmp(name, "N/A") == 0) name = summary->first.ip;
+        snprintf(buffer, size, "%s is DOWN", name);
+    } else if (summary->recovered > 0) {
+        snprintf(buffer, size, "%d hosts down (%d already back)", summary->went_down, summary->recovered);
+    } else {
+        snprintf(buffer, size, "%d hosts down", summary->went_down);
+    }
+}
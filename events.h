@@ -0,0 +1,47 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "monitor.h"
+
+// --- Status Event Dispatch ---
+// Monitor threads never call a sink directly. They push each StatusChange
+// into a single-producer/single-consumer ring and move on; one dispatch
+// thread drains it, writes every change to the notify sinks and the status
+// change hook, and folds DOWN transitions into rate-limited alerts, so a
+// switch reboot becomes one "42 hosts down" instead of 42 overlapping sounds.
+// Producers on different threads (discovery workers, the network thread)
+// take turns on a producer-side lock; the consumer never takes it.
+
+#define EVENT_QUEUE_CAPACITY 4096 // Power of two
+#define ALERT_COALESCE_MS 500     // DOWNs arriving this close together form one alert
+#define ALERT_MIN_INTERVAL_MS 5000 // At most one alert this often; later DOWNs wait and join the next
+
+// One coalesced alert: every DOWN transition since the previous alert.
+typedef struct {
+    int went_down;
+    int recovered; // Hosts that came back from DOWN in the same window
+    StatusChange first; // The first host that went DOWN, for a one-host message
+} AlertSummary;
+
+// Called on the dispatch thread. Anything that must run on the UI thread,
+// such as playing a sound, has to be handed over from here.
+typedef void (*AlertHook)(const AlertSummary* summary);
+
+extern AlertHook alert_hook; // Optional, set before events_start()
+
+bool events_start(void);
+
+// Queues the changes for dispatch. Safe from any thread; blocks only while
+// the ring is full.
+void events_publish(const StatusChange* changes, int count);
+
+// Delivers everything still queued, then stops the dispatch thread.
+void events_stop(void);
+
+// Formats "host went down" or "N hosts down" for display.
+void alert_summary_describe(const AlertSummary* summary, char* buffer, size_t size);
+
+#endif
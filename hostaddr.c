@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hostaddr.h"
+#include "hostindex.h"
+
+#ifdef _WIN32
+#include <iphlpapi.h>
+#else
+#include <arpa/inet.h>
+#include <net/if.h>
+#endif
+
+#define IPV6_INITIAL_SLOTS 64
+
+typedef struct {
+    struct in6_addr addr;
+    uint32_t scope_id;
+} Ipv6Host;
+
+// --- IPv6 Table (guarded by ipv6_mutex) ---
+// hosts[id - 1] is the address of id; slots is an open-addressing set of ids
+// keyed by address, 0 marking an empty slot.
+static pthread_mutex_t ipv6_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Ipv6Host* ipv6_hosts = NULL;
+static uint32_t ipv6_count = 0;
+static uint32_t ipv6_capacity = 0;
+static uint32_t* ipv6_slots = NULL;
+static size_t ipv6_slot_count = 0; // Power of two
+RemoteAddrFormatter remote_addr_formatter = NULL;
+
+bool host_id_is_ipv6(uint32_t id) {
+    return id != 0 && id < HOST_ID_IPV6_LIMIT;
+}
+
+bool host_id_is_remote(uint32_t id) {
+    return id >= HOST_ID_REMOTE_BASE;
+}
+
+static size_t ipv6_hash(const struct in6_addr* addr, uint32_t scope_id) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (int i = 0; i < 16; i++) {
+        hash ^= addr->s6_addr[i];
+        hash *= 16777619u;
+    }
+    return (size_t)(hash ^ scope_id);
+}
+
+static bool ipv6_equal(const Ipv6Host* host, const struct in6_addr* addr, uint32_t scope_id) {
+    return host->scope_id == scope_id && memcmp(&host->addr, addr, sizeof(*addr)) == 0;
+}
+
+static bool ipv6_grow_slots(void) {
+    size_t new_count = ipv6_slot_count ? ipv6_slot_count * 2 : IPV6_INITIAL_SLOTS;
+    uint32_t* new_slots = calloc(new_count, sizeof(uint32_t));
+    if (!new_slots) return false;
+    for (uint32_t id = 1; id <= ipv6_count; id++) {
+        const Ipv6Host* host = &ipv6_hosts[id - 1];
+        size_t slot = ipv6_hash(&host->addr, host->scope_id) & (new_count - 1);
+        while (new_slots[slot] != 0) slot = (slot + 1) & (new_count - 1);
+        new_slots[slot] = id;
+    }
+    free(ipv6_slots);
+    ipv6_slots = new_slots;
+    ipv6_slot_count = new_count;
+    return true;
+}
+
+// Caller holds ipv6_mutex.
+static uint32_t ipv6_intern(const struct in6_addr* addr, uint32_t scope_id) {
+    if (!HASH_HAS_ROOM(ipv6_count, ipv6_slot_count) && !ipv6_grow_slots()) return 0;
+
+    size_t slot = ipv6_hash(addr, scope_id) & (ipv6_slot_count - 1);
+    while (ipv6_slots[slot] != 0) {
+        if (ipv6_equal(&ipv6_hosts[ipv6_slots[slot] - 1], addr, scope_id)) return ipv6_slots[slot];
+        slot = (slot + 1) & (ipv6_slot_count - 1);
+    }
+
+    if (ipv6_count + 1 >= HOST_ID_IPV6_LIMIT) return 0;
+    if (ipv6_count == ipv6_capacity) {
+        uint32_t capacity = ipv6_capacity ? ipv6_capacity * 2 : 64;
+        Ipv6Host* hosts = realloc(ipv6_hosts, capacity * sizeof(Ipv6Host));
+        if (!hosts) return 0;
+        ipv6_hosts = hosts;
+        ipv6_capacity = capacity;
+    }
+    ipv6_hosts[ipv6_count].addr = *addr;
+    ipv6_hosts[ipv6_count].scope_id = scope_id;
+    ipv6_slots[slot] = ++ipv6_count;
+    return ipv6_count;
+}
+
+uint32_t host_id_for_ipv6(const struct in6_addr* addr, uint32_t scope_id) {
+    if (!IN6_IS_ADDR_LINKLOCAL(addr)) scope_id = 0; // Global addresses are the same host on any interface
+    pthread_mutex_lock(&ipv6_mutex);
+    uint32_t id = ipv6_intern(addr, scope_id);
+    pthread_mutex_unlock(&ipv6_mutex);
+    return id;
+}
+
+// Copies out the address of an IPv6 id. False if the id was never handed out.
+static bool ipv6_lookup(uint32_t id, Ipv6Host* out) {
+    pthread_mutex_lock(&ipv6_mutex);
+    bool found = host_id_is_ipv6(id) && id <= ipv6_count;
+    if (found) *out = ipv6_hosts[id - 1];
+    pthread_mutex_unlock(&ipv6_mutex);
+    return found;
+}
+
+bool host_id_sockaddr(uint32_t id, uint16_t port, struct sockaddr_storage* out, socklen_t* out_len) {
+    memset(out, 0, sizeof(*out));
+    if (host_id_is_remote(id)) return false;
+    if (!host_id_is_ipv6(id)) {
+        struct sockaddr_in* sin = (struct sockaddr_in*)out;
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        sin->sin_addr.s_addr = htonl(id);
+        *out_len = sizeof(*sin);
+        return true;
+    }
+
+    Ipv6Host host;
+    if (!ipv6_lookup(id, &host)) return false;
+    struct sockaddr_in6* sin6 = (struct sockaddr_in6*)out;
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons(port);
+    sin6->sin6_addr = host.addr;
+    sin6->sin6_scope_id = host.scope_id;
+    *out_len = sizeof(*sin6);
+    return true;
+}
+
+void format_host_addr(uint32_t id, char* buffer, size_t size) {
+    if (size == 0) return;
+    buffer[0] = '\0';
+    if (host_id_is_remote(id)) {
+        if (remote_addr_formatter) remote_addr_formatter(id, buffer, size);
+        return;
+    }
+    if (!host_id_is_ipv6(id)) {
+        struct in_addr in;
+        in.s_addr = htonl(id);
+        if (!inet_ntop(AF_INET, &in, buffer, size)) buffer[0] = '\0';
+        return;
+    }
+
+    Ipv6Host host;
+    if (!ipv6_lookup(id, &host) || !inet_ntop(AF_INET6, &host.addr, buffer, size)) return;
+    if (host.scope_id == 0) return;
+    size_t len = strlen(buffer);
+    char zone[IF_NAMESIZE];
+    if (if_indextoname(host.scope_id, zone)) {
+        snprintf(buffer + len, size - len, "%%%s", zone);
+    } else {
+        snprintf(buffer + len, size - len, "%%%u", (unsigned int)host.scope_id);
+    }
+}
+
+void host_addr_cleanup(void) {
+    pthread_mutex_lock(&ipv6_mutex);
+    free(ipv6_hosts);
+    free(ipv6_slots);
+    ipv6_hosts = NULL;
+    ipv6_slots = NULL;
+    ipv6_count = ipv6_capacity = 0;
+    ipv6_slot_count = 0;
+    pthread_mutex_unlock(&ipv6_mutex);
+}
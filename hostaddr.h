@@ -0,0 +1,55 @@
+#ifndef HOSTADDR_H
+#define HOSTADDR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600 // inet_ntop and the IPv6 helpers need Vista or later
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+// --- Host Addresses ---
+// Every host is keyed by a 32-bit id, so the table, its index, the scheduler
+// and probe batches are the same for both families. An IPv4 address is its
+// own id, in host byte order. IPv6 addresses get ids inside 0.0.0.0/8, which
+// is never a unicast destination, from an append-only table: an id is stable
+// for the life of the process but not across runs. Hosts an agent reports to
+// a collector (collector.c) get ids inside 240.0.0.0/4, which is never probed.
+
+#define HOST_ADDR_STRLEN 64 // IPv6 text plus a %interface zone
+#define HOST_ID_IPV6_LIMIT 0x01000000u // Ids from 1 up to this name IPv6 hosts
+
+#define HOST_ID_REMOTE_BASE 0xF0000000u // Ids from here up name hosts reported by agents
+
+bool host_id_is_ipv6(uint32_t id);
+bool host_id_is_remote(uint32_t id);
+
+// Formats a remote id; installed by the collector, which owns those ids.
+typedef void (*RemoteAddrFormatter)(uint32_t id, char* buffer, size_t size);
+extern RemoteAddrFormatter remote_addr_formatter;
+
+// Returns the id of addr, adding it if new. scope_id is the interface a
+// link-local address was seen on; it is ignored for any other address.
+// Returns 0 once the table is full.
+uint32_t host_id_for_ipv6(const struct in6_addr* addr, uint32_t scope_id);
+
+// Fills out with the address of id and port. False for an unknown IPv6 id
+// and for remote ids, which are not reachable from here.
+bool host_id_sockaddr(uint32_t id, uint16_t port, struct sockaddr_storage* out, socklen_t* out_len);
+
+// Dotted IPv4, or RFC 5952 IPv6 with a %zone for link-local addresses.
+// Remote ids are formatted by remote_addr_formatter.
+void format_host_addr(uint32_t id, char* buffer, size_t size);
+
+void host_addr_cleanup(void);
+
+#endif
@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hostindex.h"
+
+#define HOST_INDEX_INITIAL_SLOTS 64
+
+static size_t slot_for(uint32_t addr, size_t capacity) {
+    // Fibonacci hashing spreads consecutive addresses across the table
+    return (size_t)((addr * 2654435769u) & (capacity - 1));
+}
+
+static bool grow(HostIndex* index) {
+    size_t new_capacity = index->capacity ? index->capacity * 2 : HOST_INDEX_INITIAL_SLOTS;
+    uint32_t* new_keys = calloc(new_capacity, sizeof(uint32_t));
+    int* new_values = malloc(new_capacity * sizeof(int));
+    if (!new_keys || !new_values) {
+        free(new_keys);
+        free(new_values);
+        return false;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->keys[i] == 0) continue;
+        size_t slot = slot_for(index->keys[i], new_capacity);
+        while (new_keys[slot] != 0) slot = (slot + 1) & (new_capacity - 1);
+        new_keys[slot] = index->keys[i];
+        new_values[slot] = index->values[i];
+    }
+
+    free(index->keys);
+    free(index->values);
+    index->keys = new_keys;
+    index->values = new_values;
+    index->capacity = new_capacity;
+    return true;
+}
+
+int host_index_get(const HostIndex* index, uint32_t addr) {
+    if (index->capacity == 0 || addr == 0) return -1;
+    size_t slot = slot_for(addr, index->capacity);
+    while (index->keys[slot] != 0) {
+        if (index->keys[slot] == addr) return index->values[slot];
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    return -1;
+}
+
+bool host_index_put(HostIndex* index, uint32_t addr, int value) {
+    if (addr == 0) return false;
+    if (!HASH_HAS_ROOM(index->count, index->capacity) && !grow(index)) return false;
+
+    size_t slot = slot_for(addr, index->capacity);
+    while (index->keys[slot] != 0 && index->keys[slot] != addr) {
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    if (index->keys[slot] == 0) index->count++;
+    index->keys[slot] = addr;
+    index->values[slot] = value;
+    return true;
+}
+
+void host_index_remove(HostIndex* index, uint32_t addr) {
+    if (index->capacity == 0 || addr == 0) return;
+    size_t mask = index->capacity - 1;
+    size_t slot = slot_for(addr, index->capacity);
+    while (index->keys[slot] != addr) {
+        if (index->keys[slot] == 0) return;
+        slot = (slot + 1) & mask;
+    }
+
+    // Backward-shift deletion keeps lookups correct without tombstones
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; index->keys[next] != 0; next = (next + 1) & mask) {
+        size_t home = slot_for(index->keys[next], index->capacity);
+        // Move the entry back unless its home lies cyclically in (hole, next]
+        bool home_after_hole = (next > hole) ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!home_after_hole) {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
+        }
+    }
+    index->keys[hole] = 0;
+    index->count--;
+}
+
+void host_index_clear(HostIndex* index) {
+    if (index->keys) memset(index->keys, 0, index->capacity * sizeof(uint32_t));
+    index->count = 0;
+}
+
+void host_index_free(HostIndex* index) {
+    free(index->keys);
+    free(index->values);
+    memset(index, 0, sizeof(*index));
+}
@@ -0,0 +1,39 @@
+#ifndef HOSTINDEX_H
+#define HOSTINDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Host Address Index ---
+// Open-addressing hash map from a host id (hostaddr.h) to an int chosen by
+// the caller, such as the host's detail slot, so dedupe and lookups are O(1)
+// instead of a scan of every host.
+// Not thread-safe on its own; callers hold the lock that guards the array.
+
+typedef struct {
+    uint32_t* keys; // 0 marks an empty slot (0.0.0.0 is never a host)
+    int* values;
+    size_t capacity; // Power of two
+    size_t count;
+} HostIndex;
+
+// True while one more entry keeps an open-addressing table at or below 50%
+// full, so probe runs stay short. The string arena and the IPv6 and remote
+// id sets grow on the same rule.
+#define HASH_HAS_ROOM(count, capacity) (((size_t)(count) + 1) * 2 <= (size_t)(capacity))
+
+// Returns the stored value for addr, or -1 when it is not indexed.
+int host_index_get(const HostIndex* index, uint32_t addr);
+
+// Inserts or updates addr. Returns false only if the table could not grow.
+bool host_index_put(HostIndex* index, uint32_t addr, int value);
+
+void host_index_remove(HostIndex* index, uint32_t addr);
+
+// Forgets every entry but keeps the allocated slots.
+void host_index_clear(HostIndex* index);
+
+void host_index_free(HostIndex* index);
+
+#endif
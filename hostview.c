@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "hostview.h"
+#include "monitor.h"
+
+static const char* sort_names[SORT_KEY_COUNT] = {"address", "hostname", "status", "latency"};
+static const char* filter_names[FILTER_COUNT] = {"all", "problems", "down"};
+
+const char* host_sort_name(HostSortKey key) {
+    return (key >= 0 && key < SORT_KEY_COUNT) ? sort_names[key] : "?";
+}
+
+const char* host_filter_name(HostFilter filter) {
+    return (filter >= 0 && filter < FILTER_COUNT) ? filter_names[filter] : "?";
+}
+
+void host_view_set_sort(HostView* view, HostSortKey key) {
+    view->sort_key = key;
+    view->built = false;
+}
+
+void host_view_set_filter(HostView* view, HostFilter filter) {
+    view->filter = filter;
+    view->first_row = 0; // The old position means nothing in a different list
+    view->built = false;
+}
+
+static bool host_passes(const MonitoredHost* host, HostFilter filter) {
+    switch (filter) {
+        case FILTER_PROBLEMS: return host->status == STATUS_UNSTABLE || host->status == STATUS_DOWN;
+        case FILTER_DOWN: return host->status == STATUS_DOWN;
+        default: return true;
+    }
+}
+
+// Ascending key order is display order, so "worst first" keys are inverted here.
+static uint32_t sort_key_for(const MonitoredHost* host, HostSortKey key) {
+    switch (key) {
+        case SORT_STATUS:
+            switch (host->status) {
+                case STATUS_DOWN: return 0;
+                case STATUS_UNSTABLE: return 1;
+                case STATUS_SCANNING: return 2;
+                default: return 3;
+            }
+        case SORT_LATENCY:
+            if (host->rtt_avg_us == RTT_LOST) return UINT32_MAX; // Never answered: after everyone who did
+            return UINT32_MAX - 1 - host->rtt_avg_us;
+        default:
+            return host->addr;
+    }
+}
+
+static int compare_pinned_then_row(const HostSortEntry* entry_a, const HostSortEntry* entry_b, int by_key) {
+    if (entry_a->pinned != entry_b->pinned) return entry_a->pinned ? 1 : -1;
+    if (by_key != 0) return by_key;
+    if (entry_a->row != entry_b->row) return entry_a->row < entry_b->row ? -1 : 1;
+    return 0;
+}
+
+static int compare_by_key(const void* a, const void* b) {
+    const HostSortEntry* entry_a = (const HostSortEntry*)a;
+    const HostSortEntry* entry_b = (const HostSortEntry*)b;
+    int by_key = (entry_a->key == entry_b->key) ? 0 : (entry_a->key < entry_b->key ? -1 : 1);
+    return compare_pinned_then_row(entry_a, entry_b, by_key);
+}
+
+// Sorting runs under host_list_mutex, so the hostnames cannot change mid-sort.
+static int compare_by_hostname(const void* a, const void* b) {
+    const HostSortEntry* entry_a = (const HostSortEntry*)a;
+    const HostSortEntry* entry_b = (const HostSortEntry*)b;
+    int by_name = strcasecmp(discovered_hosts[entry_a->row].hostname, discovered_hosts[entry_b->row].hostname);
+    return compare_pinned_then_row(entry_a, entry_b, by_name);
+}
+
+static bool host_view_reserve(HostView* view, int count) {
+    if (count <= view->capacity) return true;
+    int capacity = view->capacity ? view->capacity : 256;
+    while (capacity < count) capacity *= 2;
+    int* rows = realloc(view->rows, capacity * sizeof(int));
+    if (!rows) return false;
+    view->rows = rows;
+    HostSortEntry* entries = realloc(view->entries, capacity * sizeof(HostSortEntry));
+    if (!entries) return false;
+    view->entries = entries;
+    view->capacity = capacity;
+    return true;
+}
+
+void host_view_refresh(HostView* view) {
+    if (view->built && view->built_version == host_table_version) return;
+    if (!host_view_reserve(view, discovered_hosts_count)) return; // Keep the old rows; retried next frame
+
+    int count = 0;
+    view->online_count = view->unstable_count = view->down_count = 0;
+    for (int i = 0; i < discovered_hosts_count; i++) {
+        const MonitoredHost* host = &discovered_hosts[i];
+        bool internet = (host->flags & HOST_FLAG_PINNED) != 0;
+        if (!internet) {
+            if (host->status == STATUS_UP) view->online_count++;
+            else if (host->status == STATUS_UNSTABLE) view->unstable_count++;
+            else if (host->status == STATUS_DOWN) view->down_count++;
+        }
+        if (!host_passes(host, view->filter)) continue;
+
+        HostSortEntry* entry = &view->entries[count++];
+        entry->key = sort_key_for(host, view->sort_key);
+        entry->row = i;
+        entry->pinned = internet;
+    }
+    // The table is kept in address order with pinned hosts last, so only the other keys need a sort
+    if (view->sort_key == SORT_HOSTNAME) qsort(view->entries, count, sizeof(HostSortEntry), compare_by_hostname);
+    else if (view->sort_key != SORT_ADDRESS) qsort(view->entries, count, sizeof(HostSortEntry), compare_by_key);
+    for (int i = 0; i < count; i++) view->rows[i] = view->entries[i].row;
+
+    view->row_count = count;
+    view->built_version = host_table_version;
+    view->built = true;
+}
+
+void host_view_scroll(HostView* view, int delta, int visible_rows) {
+    int max_first = view->row_count - (visible_rows > 0 ? visible_rows : 1);
+    view->first_row += delta;
+    if (view->first_row > max_first) view->first_row = max_first;
+    if (view->first_row < 0) view->first_row = 0;
+}
+
+void host_view_free(HostView* view) {
+    free(view->rows);
+    free(view->entries);
+    memset(view, 0, sizeof(*view));
+}
@@ -0,0 +1,62 @@
+#ifndef HOSTVIEW_H
+#define HOSTVIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Host List View ---
+// The window never walks discovered_hosts to draw. It keeps a filtered,
+// sorted list of row indices, rebuilt only when host_table_version or the
+// view settings change, and draws just the rows between first_row and the
+// bottom of the window. A frame over 5,000 hosts costs the same as one over 30.
+
+typedef enum {
+    SORT_ADDRESS,
+    SORT_HOSTNAME,
+    SORT_STATUS,  // Worst first: DOWN, UNSTABLE, scanning, UP
+    SORT_LATENCY, // Slowest average RTT first
+    SORT_KEY_COUNT
+} HostSortKey;
+
+typedef enum {
+    FILTER_ALL,
+    FILTER_PROBLEMS, // UNSTABLE and DOWN
+    FILTER_DOWN,
+    FILTER_COUNT
+} HostFilter;
+
+typedef struct {
+    uint32_t key;
+    int row;       // Tie-break: the table is in address order, so equal keys keep it
+    bool pinned;   // The internet check always sorts last
+} HostSortEntry;
+
+typedef struct {
+    int* rows; // Indices into discovered_hosts, in display order
+    HostSortEntry* entries; // Scratch for sorting, kept between rebuilds
+    int row_count;
+    int capacity;
+    int first_row; // Scroll position
+    HostSortKey sort_key;
+    HostFilter filter;
+    bool built;
+    unsigned int built_version; // host_table_version the rows were built from
+    int online_count, unstable_count, down_count; // Whole table, without the internet check
+} HostView;
+
+// Rebuilds rows if the table or the settings changed since the last call.
+// Caller holds host_list_mutex; the rows are valid until it is released.
+void host_view_refresh(HostView* view);
+
+void host_view_set_sort(HostView* view, HostSortKey key);
+void host_view_set_filter(HostView* view, HostFilter filter);
+
+// Moves first_row by delta rows, keeping a full page in view where possible.
+void host_view_scroll(HostView* view, int delta, int visible_rows);
+
+const char* host_sort_name(HostSortKey key);
+const char* host_filter_name(HostFilter filter);
+
+void host_view_free(HostView* view);
+
+#endif
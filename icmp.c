@@ -0,0 +1,210 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe_backend.h"
+#include "hostaddr.h"
+
+#ifndef IPPROTO_ICMP
+#define IPPROTO_ICMP 1
+#endif
+#ifndef IPPROTO_ICMPV6
+#define IPPROTO_ICMPV6 58
+#endif
+
+// --- ICMP Echo Backend ---
+// Prefers an unprivileged ping socket (SOCK_DGRAM/IPPROTO_ICMP, allowed on
+// Linux by net.ipv4.ping_group_range) and falls back to a raw socket, which
+// needs root, CAP_NET_RAW or an administrator on Windows. Replies are
+// matched by sequence number (the target index) and source address. IPv6
+// targets go out as ICMPv6 echo on a socket of their own.
+
+#define ICMP_ECHO_REPLY 0
+#define ICMP_ECHO_REQUEST 8
+#define ICMP6_ECHO_REQUEST 128
+#define ICMP6_ECHO_REPLY 129
+#define ICMP_HEADER_LEN 8
+#define ICMP_PAYLOAD "netmon\0\0" // Pads each request to ICMP_ECHO_LEN bytes
+#define ICMP_PAYLOAD_LEN 8
+#define ICMP_SEQ_SPACE 65536 // Target indexes are sent modulo this
+
+typedef struct {
+    probe_socket_t sock;
+    bool raw;    // Raw sockets see every ICMP packet, so the id must match too
+    bool ipv6;
+    uint16_t id; // Ping sockets overwrite it with their own
+} IcmpState;
+
+static uint16_t icmp_checksum(const uint8_t* data, int len) {
+    uint32_t sum = 0;
+    for (int i = 0; i + 1 < len; i += 2) sum += (uint32_t)(data[i] << 8 | data[i + 1]);
+    if (len & 1) sum += (uint32_t)data[len - 1] << 8;
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+probe_socket_t icmp_open(int family, bool* raw) {
+    int protocol = (family == AF_INET6) ? IPPROTO_ICMPV6 : IPPROTO_ICMP;
+    probe_socket_t sock = PROBE_INVALID_SOCKET;
+#ifndef _WIN32
+    sock = socket(family, SOCK_DGRAM, protocol);
+    *raw = false;
+#endif
+    if (sock == PROBE_INVALID_SOCKET) {
+        sock = socket(family, SOCK_RAW, protocol);
+        *raw = true;
+    }
+    if (sock == PROBE_INVALID_SOCKET) return sock;
+
+#ifdef _WIN32
+    // Windows only delivers to raw sockets that are bound
+    struct sockaddr_storage local;
+    memset(&local, 0, sizeof(local));
+    local.ss_family = (ADDRESS_FAMILY)family; // The any address is all zeroes in both families
+    bind(sock, (struct sockaddr*)&local, family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+#endif
+    int buffer_size = PROBE_RCVBUF_BYTES;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&buffer_size, sizeof(buffer_size));
+    if (!probe_set_nonblocking(sock)) {
+        probe_close_socket(sock);
+        return PROBE_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+void icmp_build_echo(uint8_t* packet, bool ipv6, uint16_t id, uint16_t seq) {
+    packet[0] = ipv6 ? ICMP6_ECHO_REQUEST : ICMP_ECHO_REQUEST;
+    packet[1] = 0;
+    packet[2] = packet[3] = 0;
+    packet[4] = (uint8_t)(id >> 8);
+    packet[5] = (uint8_t)id;
+    packet[6] = (uint8_t)(seq >> 8);
+    packet[7] = (uint8_t)seq;
+    memcpy(packet + ICMP_HEADER_LEN, ICMP_PAYLOAD, ICMP_PAYLOAD_LEN);
+    if (ipv6) return; // The ICMPv6 checksum covers a pseudo-header; the kernel fills it in
+    uint16_t sum = icmp_checksum(packet, ICMP_ECHO_LEN);
+    packet[2] = (uint8_t)(sum >> 8);
+    packet[3] = (uint8_t)sum;
+}
+
+int icmp_parse_reply(const uint8_t* packet, int len, bool ipv6, bool raw, uint16_t id) {
+    // Raw IPv4 sockets, and IPv4 ping sockets outside Linux, hand over the IP header too
+    const uint8_t* reply = packet;
+#ifdef __linux__
+    bool has_ip_header = !ipv6 && raw;
+#else
+    bool has_ip_header = !ipv6;
+#endif
+    if (has_ip_header) {
+        if (len < 20 || (packet[0] >> 4) != 4) return -1;
+        int header_len = (packet[0] & 0x0F) * 4;
+        reply += header_len;
+        len -= header_len;
+    }
+    if (len < ICMP_HEADER_LEN || reply[0] != (ipv6 ? ICMP6_ECHO_REPLY : ICMP_ECHO_REPLY)) return -1;
+    if (raw && (uint16_t)(reply[4] << 8 | reply[5]) != id) return -1;
+    return reply[6] << 8 | reply[7];
+}
+
+static PacketSendResult icmp_send(void* state, const ProbeTarget* target, int index) {
+    IcmpState* icmp = (IcmpState*)state;
+    uint8_t packet[ICMP_ECHO_LEN];
+    icmp_build_echo(packet, icmp->ipv6, icmp->id, (uint16_t)(index % ICMP_SEQ_SPACE));
+
+    struct sockaddr_storage dest;
+    socklen_t dest_len;
+    if (!host_id_sockaddr(target->addr, 0, &dest, &dest_len)) return PACKET_FAILED;
+    if (sendto(icmp->sock, (const char*)packet, sizeof(packet), 0, (struct sockaddr*)&dest, dest_len) >= 0) return PACKET_SENT;
+
+    int err = probe_last_error();
+#ifdef _WIN32
+    if (err == WSAEWOULDBLOCK || err == WSAENOBUFS) return PACKET_BLOCKED;
+#else
+    if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS) return PACKET_BLOCKED;
+#endif
+    return PACKET_FAILED;
+}
+
+// True when the reply came from the target's address.
+static bool icmp_reply_from(const ProbeTarget* target, const struct sockaddr_storage* from) {
+    if (from->ss_family == AF_INET) {
+        return !host_id_is_ipv6(target->addr) && ntohl(((const struct sockaddr_in*)from)->sin_addr.s_addr) == target->addr;
+    }
+    struct sockaddr_storage expected;
+    socklen_t expected_len;
+    if (from->ss_family != AF_INET6 || !host_id_sockaddr(target->addr, 0, &expected, &expected_len)) return false;
+    if (expected.ss_family != AF_INET6) return false;
+    return memcmp(&((const struct sockaddr_in6*)from)->sin6_addr, &((struct sockaddr_in6*)&expected)->sin6_addr, sizeof(struct in6_addr)) == 0;
+}
+
+static int icmp_receive(void* state, const ProbeTarget* targets, int count, ProbeOutcome* outcome) {
+    (void)outcome;
+    IcmpState* icmp = (IcmpState*)state;
+    uint8_t packet[PROBE_PACKET_MAX];
+    struct sockaddr_storage from;
+    socklen_t from_len = sizeof(from);
+    int len = (int)recvfrom(icmp->sock, (char*)packet, sizeof(packet), 0, (struct sockaddr*)&from, &from_len);
+    if (len < 0) return PACKET_DRAINED;
+
+    int seq = icmp_parse_reply(packet, len, icmp->ipv6, icmp->raw, icmp->id);
+    if (seq < 0) return PACKET_NO_MATCH;
+    for (int index = seq; index < count; index += ICMP_SEQ_SPACE) {
+        if (icmp_reply_from(&targets[index], &from)) return index;
+    }
+    return PACKET_NO_MATCH;
+}
+
+// Probes targets that are all of one family.
+static int icmp_family_batch(int family, const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    static uint16_t next_id = 0; // Keeps concurrent raw-socket batches apart
+    IcmpState icmp;
+    icmp.ipv6 = (family == AF_INET6);
+    icmp.sock = icmp_open(family, &icmp.raw);
+    if (icmp.sock == PROBE_INVALID_SOCKET) return -1;
+#ifdef _WIN32
+    icmp.id = (uint16_t)(GetCurrentProcessId() + __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED));
+#else
+    icmp.id = (uint16_t)(getpid() + __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED));
+#endif
+
+    PacketBackend backend = {icmp.sock, &icmp, icmp_send, icmp_receive};
+    int sent = probe_packet_batch(&backend, targets, count, options);
+    probe_close_socket(icmp.sock);
+    return sent;
+}
+
+int icmp_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    if (!options || !options->on_result) return -1;
+
+    int ipv6_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (host_id_is_ipv6(targets[i].addr)) ipv6_count++;
+    }
+    if (ipv6_count == 0) return icmp_family_batch(AF_INET, targets, count, options);
+    if (ipv6_count == count) return icmp_family_batch(AF_INET6, targets, count, options);
+
+    // Each family needs its own socket: split the batch and run the halves in turn
+    ProbeTarget* split = malloc(count * sizeof(ProbeTarget));
+    if (!split) return -1;
+    int ipv4_count = 0, next_ipv6 = count - ipv6_count;
+    for (int i = 0; i < count; i++) {
+        if (host_id_is_ipv6(targets[i].addr)) split[next_ipv6++] = targets[i];
+        else split[ipv4_count++] = targets[i];
+    }
+    int sent_ipv4 = icmp_family_batch(AF_INET, split, ipv4_count, options);
+    int sent_ipv6 = icmp_family_batch(AF_INET6, split + ipv4_count, ipv6_count, options);
+    free(split);
+    if (sent_ipv4 < 0 && sent_ipv6 < 0) return -1;
+    return (sent_ipv4 > 0 ? sent_ipv4 : 0) + (sent_ipv6 > 0 ? sent_ipv6 : 0);
+}
+
+bool icmp_available(void) {
+    bool raw;
+    probe_socket_t sock = icmp_open(AF_INET, &raw);
+    if (sock == PROBE_INVALID_SOCKET) return false;
+    probe_close_socket(sock);
+    return true;
+}
@@ -0,0 +1,127 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "inventory.h"
+
+#define INVENTORY_HEADER_SIZE 16 // Magic, u16 version, u16 reserved, u32 count
+
+static void put_u16(unsigned char* out, uint16_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    put_u16(out, (uint16_t)value);
+    put_u16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_u16(const unsigned char* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    return (uint32_t)get_u16(in) | ((uint32_t)get_u16(in + 2) << 16);
+}
+
+int inventory_load(const char* path, InventoryCallback on_record, void* ctx) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        if (errno == ENOENT) return 0;
+        printf("Could not open inventory %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    unsigned char header[INVENTORY_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, INVENTORY_MAGIC, 8) != 0) {
+        printf("Ignoring %s: not a host inventory\n", path);
+        fclose(file);
+        return -1;
+    }
+    if (get_u16(header + 8) != INVENTORY_VERSION) {
+        printf("Ignoring %s: inventory version %u, expected %u\n", path, get_u16(header + 8), INVENTORY_VERSION);
+        fclose(file);
+        return -1;
+    }
+    uint32_t count = get_u32(header + 12);
+    if (count > INVENTORY_MAX_HOSTS) {
+        printf("Ignoring %s: implausible host count %u\n", path, count);
+        fclose(file);
+        return -1;
+    }
+
+    // Read everything before reporting anything, so a truncated file restores no hosts at all
+    InventoryRecord* records = malloc((count ? count : 1) * sizeof(InventoryRecord));
+    if (!records) {
+        fclose(file);
+        return -1;
+    }
+    uint32_t loaded = 0;
+    for (; loaded < count; loaded++) {
+        unsigned char fixed[8]; // u32 addr, u16 port, u8 status, u8 hostname length
+        if (fread(fixed, 1, sizeof(fixed), file) != sizeof(fixed)) break;
+        InventoryRecord* record = &records[loaded];
+        record->addr = get_u32(fixed);
+        record->preferred_port = get_u16(fixed + 4);
+        if (fixed[6] > STATUS_DOWN) break;
+        record->status = (HostStatus)fixed[6];
+        if (fread(record->hostname, 1, fixed[7], file) != fixed[7]) break;
+        record->hostname[fixed[7]] = '\0';
+    }
+    fclose(file);
+    if (loaded != count) {
+        printf("Ignoring %s: truncated or corrupt after %u of %u hosts\n", path, loaded, count);
+        free(records);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) on_record(&records[i], ctx);
+    free(records);
+    return (int)count;
+}
+
+bool inventory_save(const char* path, const InventoryRecord* records, int count) {
+    char temp_path[1024];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) return false;
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        printf("Could not write inventory %s: %s\n", temp_path, strerror(errno));
+        return false;
+    }
+
+    unsigned char header[INVENTORY_HEADER_SIZE];
+    memcpy(header, INVENTORY_MAGIC, 8);
+    put_u16(header + 8, INVENTORY_VERSION);
+    put_u16(header + 10, 0);
+    put_u32(header + 12, (uint32_t)count);
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    for (int i = 0; ok && i < count; i++) {
+        size_t name_len = strnlen(records[i].hostname, 255);
+        unsigned char fixed[8];
+        put_u32(fixed, records[i].addr);
+        put_u16(fixed + 4, records[i].preferred_port);
+        fixed[6] = (unsigned char)records[i].status;
+        fixed[7] = (unsigned char)name_len;
+        ok = fwrite(fixed, 1, sizeof(fixed), file) == sizeof(fixed)
+          && fwrite(records[i].hostname, 1, name_len, file) == name_len;
+    }
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Could not write inventory %s\n", temp_path);
+        remove(temp_path);
+        return false;
+    }
+
+#ifdef _WIN32
+    remove(path); // rename() will not replace an existing file on Windows
+#endif
+    if (rename(temp_path, path) != 0) {
+        printf("Could not replace inventory %s: %s\n", path, strerror(errno));
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "monitor.h"
+
+// --- Persistent Host Inventory ---
+// Known hosts are saved to a small binary file so a restart can monitor them
+// at once instead of waiting for a full discovery sweep. The file is an
+// 8-byte magic, a version and a record count, then one variable-length
+// record per host, all little-endian. Saves go to a temporary file that is
+// renamed over the old one, so a crash never leaves a torn inventory.
+
+#define INVENTORY_MAGIC "NMINV\r\n\032" // Exactly 8 bytes; the CR/LF/^Z catch text-mode mangling
+#define INVENTORY_VERSION 1
+#define INVENTORY_MAX_HOSTS 1000000 // Sanity bound on the header's record count
+
+typedef struct {
+    uint32_t addr;
+    uint16_t preferred_port; // Port that answered last, 0 for none or non-TCP
+    HostStatus status;       // Last known status
+    char hostname[256];
+} InventoryRecord;
+
+typedef void (*InventoryCallback)(const InventoryRecord* record, void* ctx);
+
+// Calls on_record for every record in path. Returns the number of records,
+// 0 when the file does not exist, or -1 when it is unreadable or from
+// another version; in that case nothing is reported and a sweep is needed.
+int inventory_load(const char* path, InventoryCallback on_record, void* ctx);
+
+bool inventory_save(const char* path, const InventoryRecord* records, int count);
+
+#endif
@@ -1,79 +1,72 @@
 #define _GNU_SOURCE
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
-#include <SDL2/SDL_mixer.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <pthread.h>
+
+#ifndef NETMON_NO_GUI
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_mixer.h>
 #include <math.h> // Needed for sin() in sound generation
+#include <time.h>
+#endif
 
 // --- Platform-specific headers from our previous C scanner ---
 #ifdef _WIN32
 #include <winsock2.h>
-#include <ws2tcpip.h>
-#include <iphlpapi.h>
 #include <windows.h>
 // #pragma comment directives are not needed as linking is handled in the Makefile
 #else
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netdb.h>
-#include <ifaddrs.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
+#include <signal.h>
+#endif
+
+#include "monitor.h"
+#include "options.h"
+#include "notify.h"
+#include "metrics.h"
+#include "events.h"
+#include "scheduler.h"
+#include "trace.h"
+#ifndef NETMON_NO_GUI
+#include "textcache.h"
+#include "sparkline.h"
+#include "hostview.h"
+#include "font.h" // font.ttf as a byte array (xxd -i font.ttf), so no font file is needed at run time
 #endif
 
+// Building with -DNETMON_NO_GUI (make headless) drops the window, font and
+// audio entirely, so the binary links without SDL and always runs headless.
+#ifndef NETMON_NO_GUI
 // --- Configuration ---
-#define SCREEN_WIDTH 800
+#define SCREEN_WIDTH 800 // Initial window size; the window can be resized
 #define SCREEN_HEIGHT 600
-#define DEFAULT_SUBNET "192.168.1." // Fallback subnet
-#define INTERNET_CHECK_IP "8.8.8.8" // Google's public DNS for internet check
-#define START_HOST 1
-#define END_HOST 254
-#define NUM_THREADS 50
-#define CONNECT_TIMEOUT_MS 200
-#define MONITOR_INTERVAL_S 5
-#define PING_FAIL_THRESHOLD 3
 #define SAMPLE_RATE 44100 // For audio generation
+#define ALERT_SAMPLES (SAMPLE_RATE / 4) // Quarter-second two-tone alert
 #define FONT_SIZE 14 // Reduced font size
 #define NUM_STARS 500 // Number of stars for the background activity indicator
+#define STAR_SPEED 30.0f // Depth units per second (the old 0.5 per frame at 60 fps)
+
+// --- Redraw Pacing ---
+#define FRAME_INTERVAL_MS 16 // Frame cap, and the frame rate of continuous mode
+#define IDLE_WAIT_MS 1000 // Longest sleep between event checks when nothing changes
+#define FLASH_DECAY_PER_S 3.0f // A status flash fades out in about a third of a second
 
 // --- Layout Defines for Tabulation ---
 #define COLUMN_STATUS_ICON_X 15
 #define COLUMN_IP_ADDR_X 45
 #define COLUMN_HOSTNAME_X 280      // FIX: Pushed further right for better spacing
+#define COLUMN_SPARKLINE_X 510
 #define COLUMN_STATUS_TEXT_X 620   // Kept the same as per request
-
-const int COMMON_PORTS[] = {21, 22, 23, 80, 443, 445, 3389, 8080};
-const int NUM_COMMON_PORTS = sizeof(COMMON_PORTS) / sizeof(COMMON_PORTS[0]);
+#define SPARKLINE_WIDTH 96
+#define ROW_HEIGHT (FONT_SIZE + 4)
+#define DETAIL_PANE_HEIGHT 112 // Bottom pane for the selected host's timeline
+#define SCROLLBAR_WIDTH 6
+#define WHEEL_SCROLL_ROWS 3
+#define TRACE_OVERLAY_WIDTH 420 // Debug overlay box (F3, built with make TRACE=1)
 
 // --- Enums and Structs ---
-typedef enum {
-    STATUS_SCANNING,
-    STATUS_UP,
-    STATUS_UNSTABLE,
-    STATUS_DOWN
-} HostStatus;
-
-typedef struct {
-    char ip[16];
-    char hostname[256]; // Field for resolved hostname
-    HostStatus status;
-    int consecutive_failures;
-    float flash_timer; // For status change animation
-} MonitoredHost;
-
-typedef struct {
-    int start_host;
-    int end_host;
-    char subnet[16]; // Pass the detected subnet to each thread
-} DiscoveryThreadArgs;
-
 typedef struct {
     float x, y, z;
 } Star;
@@ -84,16 +77,27 @@ SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
 TTF_Font* font = NULL;
 Mix_Chunk* alert_sound = NULL;
-
-MonitoredHost* discovered_hosts = NULL;
-int discovered_hosts_count = 0;
-int discovered_hosts_capacity = 0;
-bool discovery_complete = false;
+Sint16 alert_samples[ALERT_SAMPLES]; // Mix_QuickLoad_RAW plays from this buffer without copying it
 Star stars[NUM_STARS];
-char active_subnet[16] = ""; // Store the detected subnet globally for display
+SDL_Vertex star_vertices[NUM_STARS * 4]; // Visible stars as quads, rebuilt when they move
+int star_indices[NUM_STARS * 6];
+int star_vertex_count = 0;
+Uint32 stars_updated_at = 0;
+bool stars_built = false;
+Uint32 redraw_event = (Uint32)-1; // SDL user event posted by request_redraw()
+int redraw_pending = 0; // Set while a redraw event is queued
+SparklineBatch sparklines = {NULL, NULL, 0, 0, 0, 0}; // Every graph of a frame, drawn in one call
+uint32_t selected_host = 0; // Address shown in the detail pane, 0 = none
+pthread_mutex_t alert_mutex = PTHREAD_MUTEX_INITIALIZER; // Guards last_alert between the dispatch and UI threads
+char last_alert[112] = ""; // Shown in the header once an alert has fired
+int alert_pending = 0; // Set by on_alert, cleared when the UI thread plays the sound
+int host_list_top = 0; // y of the first host row, for mouse hit tests
+int host_list_rows = 0; // Rows that fit between host_list_top and the detail pane
+HostView host_view; // Filtered, sorted rows of the host list
+int window_width = SCREEN_WIDTH;
+int window_height = SCREEN_HEIGHT;
+bool show_trace_overlay = false; // Toggled with F3 in traced builds
 
-pthread_mutex_t host_list_mutex;
-volatile bool app_is_running = true; // FIX: Global flag for graceful thread shutdown
 
 // --- Function Prototypes ---
 bool init_sdl();
@@ -101,29 +105,31 @@ void init_stars();
 bool load_media();
 void create_alert_sound();
 void cleanup();
-void* network_thread_main(void* arg);
-bool check_port(const char* ip, int port);
-int compare_hosts(const void* a, const void* b);
+void on_alert(const AlertSummary* summary);
+void play_pending_alert(void);
 void render_text(const char* text, int x, int y, SDL_Color color);
+void update_stars(float seconds);
 void update_and_render_stars();
-bool get_local_ip_and_subnet(char* subnet_buffer, size_t buffer_size);
+void select_host_at(int y);
+void render_host_detail(const MonitoredHost* host, int top);
+bool render_frame(float elapsed_s);
+bool handle_event(const SDL_Event* e);
+bool handle_key(SDL_Keycode key);
+void render_scrollbar(int top, int bottom);
+void render_trace_overlay(void);
+void request_redraw(void);
+int run_gui();
+#endif
+int run_headless();
 
 
 // --- Main Application ---
 int main(int argc, char* argv[]) {
-    // Check for command-line argument for the subnet
-    if (argc > 1) {
-        // Basic validation: ensure it's a reasonable length and ends with a dot
-        size_t len = strlen(argv[1]);
-        if (len > 0 && len < 16 && argv[1][len - 1] == '.') {
-            strncpy(active_subnet, argv[1], sizeof(active_subnet) - 1);
-            printf("Using user-provided subnet: %s\n", active_subnet);
-        } else {
-            printf("Invalid subnet format provided: '%s'. It should be like '192.168.1.'\n", argv[1]);
-            return 1;
-        }
-    }
-
+#ifdef NETMON_NO_GUI
+    headless_mode = true;
+#endif
+    if (!parse_arguments(argc, argv)) return 1;
+    configure_scan_limits();
 
 #ifdef _WIN32
     WSADATA wsaData;
@@ -134,312 +140,490 @@ int main(int argc, char* argv[]) {
     }
 #endif
 
+    if (headless_mode) notify_enable_stdout();
+    int result = 1;
+    if (notify_start() && metrics_start()) {
+#ifdef NETMON_NO_GUI
+        result = run_headless();
+#else
+        result = headless_mode ? run_headless() : run_gui();
+#endif
+    }
+
+    metrics_stop();
+    notify_shutdown();
+    trace_finish(); // Every traced thread has stopped by now
+    monitor_cleanup();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return result;
+}
+
+// --- Headless Mode ---
+#ifdef _WIN32
+static BOOL WINAPI on_console_signal(DWORD type) {
+    (void)type;
+    app_is_running = false;
+    scheduler_wake();
+    return TRUE;
+}
+#endif
+
+// Runs the monitor with no window until SIGINT or SIGTERM (Ctrl+C on Windows).
+int run_headless() {
+#ifdef _WIN32
+    SetConsoleCtrlHandler(on_console_signal, TRUE);
+#else
+    // Block the signals before any thread starts so only sigwait() below sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+#endif
+
+    if (!monitor_start()) return 1;
+
+#ifdef _WIN32
+    while (app_is_running) Sleep(200);
+#else
+    int sig;
+    sigwait(&signals, &sig);
+    printf("Received signal %d.\n", sig);
+#endif
+    monitor_stop();
+    return 0;
+}
+
+#ifndef NETMON_NO_GUI
+// --- GUI Mode ---
+int run_gui() {
     if (!init_sdl() || !load_media()) {
         cleanup();
         return 1;
     }
 
     init_stars();
-    pthread_mutex_init(&host_list_mutex, NULL);
-
-    pthread_t network_thread;
-    if (pthread_create(&network_thread, NULL, network_thread_main, NULL) != 0) {
-        printf("Failed to create network thread!\n");
+    redraw_event = SDL_RegisterEvents(1);
+    alert_hook = on_alert;
+    host_table_hook = request_redraw;
+    trace_name_thread("render");
+    if (!monitor_start()) {
         cleanup();
         return 1;
     }
 
     SDL_Event e;
+    bool needs_redraw = true;
+    bool animating = false;
+    Uint32 last_frame = SDL_GetTicks();
 
     while (app_is_running) {
+        // Sleep until an event arrives, or until the next frame while one is wanted
+        bool want_frame = needs_redraw || animating || !redraw_on_change;
+        Uint32 since_frame = SDL_GetTicks() - last_frame;
+        int wait_ms = !want_frame ? IDLE_WAIT_MS : (since_frame >= FRAME_INTERVAL_MS ? 0 : (int)(FRAME_INTERVAL_MS - since_frame));
+        if (wait_ms > 0 && SDL_WaitEventTimeout(&e, wait_ms)) {
+            if (handle_event(&e)) needs_redraw = true;
+        }
         while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                app_is_running = false; // Signal threads to exit
-            }
+            if (handle_event(&e)) needs_redraw = true;
         }
+        if (!app_is_running) break;
+
+        Uint32 now = SDL_GetTicks();
+        want_frame = needs_redraw || animating || !redraw_on_change;
+        if (!want_frame || now - last_frame < FRAME_INTERVAL_MS) continue;
+
+        // Clamp so a stall does not skip an entire flash
+        float elapsed_s = (now - last_frame > 250) ? 0.25f : (now - last_frame) / 1000.0f;
+        last_frame = now;
+        needs_redraw = false;
+        uint64_t frame_start_us = trace_now();
+        animating = render_frame(elapsed_s);
+        SDL_RenderPresent(renderer);
+        trace_record(TRACE_FRAME, frame_start_us, trace_now() - frame_start_us);
+    }
 
-        // --- Rendering ---
-        SDL_SetRenderDrawColor(renderer, 20, 30, 40, 255); // Dark blue background
-        SDL_RenderClear(renderer);
+    monitor_stop();
+    cleanup();
+    return 0;
+}
 
-        update_and_render_stars();
+// Draws one frame from the host table and decays flash timers by elapsed
+// time. Returns true while something on screen is still animating.
+bool render_frame(float elapsed_s) {
+    // --- Rendering ---
+    int width = window_width, height = window_height;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    if (width < 1) width = 1; // Some platforms report 0 x 0 while minimized
+    if (height < 1) height = 1;
+    if (width != window_width || height != window_height) {
+        window_width = width;
+        window_height = height;
+        stars_built = false; // Re-project the field onto the new size
+    }
 
-        pthread_mutex_lock(&host_list_mutex);
+    SDL_SetRenderDrawColor(renderer, 20, 30, 40, 255); // Dark blue background
+    SDL_RenderClear(renderer);
 
-        int y_offset = 10;
-        char buffer[128];
-        SDL_Color white = {255, 255, 255, 255};
-        SDL_Color gray = {150, 150, 150, 255};
-        SDL_Color green = {34, 197, 94, 255};
-        SDL_Color amber = {245, 158, 11, 255};
-        SDL_Color red = {239, 68, 68, 255};
+    update_and_render_stars();
 
-        int online_count = 0, unstable_count = 0, down_count = 0;
-        for (int i = 0; i < discovered_hosts_count; i++) {
-            if (strcmp(discovered_hosts[i].ip, INTERNET_CHECK_IP) == 0) continue; // Don't include internet in summary
-            if (discovered_hosts[i].status == STATUS_UP) online_count++;
-            else if (discovered_hosts[i].status == STATUS_UNSTABLE) unstable_count++;
-            else if (discovered_hosts[i].status == STATUS_DOWN) down_count++;
-        }
+    host_list_lock();
 
-        if (!discovery_complete) {
-            snprintf(buffer, sizeof(buffer), "Discovering on %s0/24...", active_subnet);
-        } else {
-            snprintf(buffer, sizeof(buffer), "Monitoring %d hosts on %s0/24", discovered_hosts_count, active_subnet);
-        }
-        render_text(buffer, 10, y_offset, white);
-        y_offset += FONT_SIZE + 5;
-
-        // Render live summary
-        snprintf(buffer, sizeof(buffer), "Online: %d", online_count);
-        render_text(buffer, 10, y_offset, green);
-        snprintf(buffer, sizeof(buffer), "Unstable: %d", unstable_count);
-        render_text(buffer, 180, y_offset, amber); 
-        snprintf(buffer, sizeof(buffer), "Down: %d", down_count);
-        render_text(buffer, 350, y_offset, red); 
-        y_offset += FONT_SIZE + 15;
-
-        // Render column headers
-        render_text("IP Address", COLUMN_IP_ADDR_X, y_offset, gray);
-        render_text("Hostname", COLUMN_HOSTNAME_X, y_offset, gray);
-        render_text("Status", COLUMN_STATUS_TEXT_X, y_offset, gray);
-        y_offset += FONT_SIZE + 5;
-
-        // Render each host
-        for (int i = 0; i < discovered_hosts_count; i++) {
-            SDL_Rect status_rect = {COLUMN_STATUS_ICON_X, y_offset, FONT_SIZE - 2, FONT_SIZE - 2};
-            char status_desc[50];
-            const char* status_text;
-            SDL_Color status_color;
-
-            switch (discovered_hosts[i].status) {
-                case STATUS_UP:
-                    status_color = green;
+    int y_offset = 10;
+    char buffer[128];
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color gray = {150, 150, 150, 255};
+    SDL_Color green = {34, 197, 94, 255};
+    SDL_Color amber = {245, 158, 11, 255};
+    SDL_Color red = {239, 68, 68, 255};
+
+    // Summary counts come with the view, so they cost nothing on an unchanged table
+    host_view_refresh(&host_view);
+
+    if (!discovery_complete) {
+        snprintf(buffer, sizeof(buffer), "Discovering on %s...", active_subnet);
+    } else {
+        snprintf(buffer, sizeof(buffer), "Monitoring %d hosts on %s%s", discovered_hosts_count, active_subnet, rediscovery_active ? " (rescanning)" : "");
+    }
+    render_text(buffer, 10, y_offset, white);
+    pthread_mutex_lock(&alert_mutex);
+    if (last_alert[0]) {
+        snprintf(buffer, sizeof(buffer), "Last alert: %s", last_alert);
+        render_text(buffer, COLUMN_SPARKLINE_X, y_offset, red);
+    }
+    pthread_mutex_unlock(&alert_mutex);
+    y_offset += FONT_SIZE + 5;
+
+    // Render live summary
+    snprintf(buffer, sizeof(buffer), "Online: %d", host_view.online_count);
+    render_text(buffer, 10, y_offset, green);
+    snprintf(buffer, sizeof(buffer), "Unstable: %d", host_view.unstable_count);
+    render_text(buffer, 180, y_offset, amber); 
+    snprintf(buffer, sizeof(buffer), "Down: %d", host_view.down_count);
+    render_text(buffer, 350, y_offset, red); 
+    snprintf(buffer, sizeof(buffer), "[S]ort: %s  [F]ilter: %s", host_sort_name(host_view.sort_key), host_filter_name(host_view.filter));
+    render_text(buffer, COLUMN_SPARKLINE_X, y_offset, gray);
+    y_offset += FONT_SIZE + 15;
+
+    // Render column headers
+    render_text("IP Address", COLUMN_IP_ADDR_X, y_offset, gray);
+    render_text("Hostname", COLUMN_HOSTNAME_X, y_offset, gray);
+    render_text("Latency", COLUMN_SPARKLINE_X, y_offset, gray);
+    render_text("Status", COLUMN_STATUS_TEXT_X, y_offset, gray);
+    y_offset += FONT_SIZE + 5;
+
+    sparkline_batch_reset(&sparklines);
+    int selected_index = selected_host ? host_row(selected_host) : -1;
+    int list_bottom = window_height - (selected_index >= 0 ? DETAIL_PANE_HEIGHT : 0);
+    host_list_top = y_offset;
+    host_list_rows = (list_bottom > y_offset) ? (list_bottom - y_offset) / ROW_HEIGHT : 0;
+    host_view_scroll(&host_view, 0, host_list_rows); // Re-clamp after a resize or a shrinking filter
+
+    if (host_view.row_count == 0 && discovered_hosts_count > 0) {
+        render_text("No hosts match the filter", COLUMN_IP_ADDR_X, y_offset, gray);
+    }
+
+    // Render only the rows that fit; the rest of the list costs nothing
+    int last_row = host_view.first_row + host_list_rows;
+    if (last_row > host_view.row_count) last_row = host_view.row_count;
+    for (int r = host_view.first_row; r < last_row; r++) {
+        int i = host_view.rows[r];
+        const HostDetail* detail = host_detail(discovered_hosts[i].detail);
+        SDL_Rect status_rect = {COLUMN_STATUS_ICON_X, y_offset, FONT_SIZE - 2, FONT_SIZE - 2};
+        char status_desc[50];
+        const char* status_text;
+        RttStats rtt;
+        SDL_Color status_color;
+
+        switch (discovered_hosts[i].status) {
+            case STATUS_UP:
+                status_color = green;
+                rtt_compute_stats(&detail->rtt, &rtt);
+                if (rtt.count > 0) {
+                    snprintf(status_desc, sizeof(status_desc), "Online %.1f ms", rtt.avg_us / 1000.0);
+                    status_text = status_desc;
+                } else {
                     status_text = "Online";
-                    break;
-                case STATUS_UNSTABLE:
-                    status_color = amber;
+                }
+                break;
+            case STATUS_UNSTABLE:
+                status_color = amber;
+                if (discovered_hosts[i].consecutive_failures > 0) {
                     snprintf(status_desc, sizeof(status_desc), "Unstable (%d)", discovered_hosts[i].consecutive_failures);
-                    status_text = status_desc;
-                    break;
-                case STATUS_DOWN:
-                    status_color = red;
-                    status_text = "DOWN";
-                    break;
-                default:
-                    status_color = (SDL_Color){59, 130, 246, 255}; // Blue
-                    status_text = "Scanning...";
-                    break;
-            }
-            SDL_SetRenderDrawColor(renderer, status_color.r, status_color.g, status_color.b, 255);
-            SDL_RenderFillRect(renderer, &status_rect);
-
-            // Render text columns
-            render_text(discovered_hosts[i].ip, COLUMN_IP_ADDR_X, y_offset, white);
-            render_text(discovered_hosts[i].hostname, COLUMN_HOSTNAME_X, y_offset, white);
-            render_text(status_text, COLUMN_STATUS_TEXT_X, y_offset, white);
-
-            // Render flash effect on status change
-            if (discovered_hosts[i].flash_timer > 0) {
-                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(renderer, status_color.r, status_color.g, status_color.b, (Uint8)(discovered_hosts[i].flash_timer * 100));
-                SDL_Rect flash_rect = {0, y_offset - 2, SCREEN_WIDTH, FONT_SIZE + 4};
-                SDL_RenderFillRect(renderer, &flash_rect);
-                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
-                discovered_hosts[i].flash_timer -= 0.05f; // Decrease timer
-            }
-
-            y_offset += FONT_SIZE + 4;
+                } else {
+                    // Answering, but flagged because its latency degraded
+                    rtt_compute_stats(&detail->rtt, &rtt);
+                    snprintf(status_desc, sizeof(status_desc), "Slow p95 %.0f ms", rtt.p95_us / 1000.0);
+                }
+                status_text = status_desc;
+                break;
+            case STATUS_DOWN:
+                status_color = red;
+                status_text = "DOWN";
+                break;
+            default:
+                status_color = (SDL_Color){59, 130, 246, 255}; // Blue
+                status_text = "Scanning...";
+                break;
+        }
+        SDL_SetRenderDrawColor(renderer, status_color.r, status_color.g, status_color.b, 255);
+        SDL_RenderFillRect(renderer, &status_rect);
+
+        // Render text columns
+        char ip[HOST_ADDR_STRLEN];
+        format_host_addr(discovered_hosts[i].addr, ip, sizeof(ip));
+        render_text(ip, COLUMN_IP_ADDR_X, y_offset, white);
+        render_text(discovered_hosts[i].hostname, COLUMN_HOSTNAME_X, y_offset, white);
+        render_text(status_text, COLUMN_STATUS_TEXT_X, y_offset, white);
+        SDL_Rect spark_area = {COLUMN_SPARKLINE_X, y_offset, SPARKLINE_WIDTH, FONT_SIZE};
+        sparkline_add_history(&sparklines, &detail->rtt, spark_area, status_color);
+        if (i == selected_index) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_Rect outline = {2, y_offset - 2, window_width - 4, ROW_HEIGHT};
+            SDL_RenderDrawRect(renderer, &outline);
         }
-        pthread_mutex_unlock(&host_list_mutex);
-
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
-    }
 
-    // FIX: Wait for the network thread to finish cleanly instead of cancelling it
-    printf("Shutting down network thread...\n");
-    pthread_join(network_thread, NULL);
-    printf("Network thread joined. Exiting.\n");
+        // Render flash effect on status change
+        if (discovered_hosts[i].flash_timer > 0) {
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+            SDL_SetRenderDrawColor(renderer, status_color.r, status_color.g, status_color.b, (Uint8)(discovered_hosts[i].flash_timer * 100));
+            SDL_Rect flash_rect = {0, y_offset - 2, window_width, FONT_SIZE + 4};
+            SDL_RenderFillRect(renderer, &flash_rect);
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        }
 
-    cleanup();
-    return 0;
-}
+        y_offset += ROW_HEIGHT;
+    }
+    render_scrollbar(host_list_top, host_list_top + host_list_rows * ROW_HEIGHT);
+    if (selected_index >= 0) render_host_detail(&discovered_hosts[selected_index], list_bottom);
 
-// --- Networking Thread Logic ---
-void add_host_to_list(const char* ip, const char* hostname_override) {
-    pthread_mutex_lock(&host_list_mutex);
+    // Decay every flash, drawn or not, so off-screen rows do not keep the UI animating
+    bool flashing = false;
     for (int i = 0; i < discovered_hosts_count; i++) {
-        if (strcmp(discovered_hosts[i].ip, ip) == 0) {
-            pthread_mutex_unlock(&host_list_mutex);
-            return;
-        }
+        if (discovered_hosts[i].flash_timer <= 0) continue;
+        discovered_hosts[i].flash_timer -= FLASH_DECAY_PER_S * elapsed_s;
+        if (discovered_hosts[i].flash_timer > 0) flashing = true;
     }
+    host_list_unlock();
 
-    if (discovered_hosts_count >= discovered_hosts_capacity) {
-        discovered_hosts_capacity = (discovered_hosts_capacity == 0) ? 10 : discovered_hosts_capacity * 2;
-        discovered_hosts = realloc(discovered_hosts, discovered_hosts_capacity * sizeof(MonitoredHost));
-    }
+    // Every sparkline of the frame goes out in this one draw call
+    sparkline_batch_draw(&sparklines, renderer);
+    if (show_trace_overlay) render_trace_overlay();
 
-    int index = discovered_hosts_count;
-    strncpy(discovered_hosts[index].ip, ip, 15);
-    discovered_hosts[index].ip[15] = '\0';
-    discovered_hosts[index].status = STATUS_UP;
-    discovered_hosts[index].consecutive_failures = 0;
-    discovered_hosts[index].flash_timer = 1.0f; // Flash on discovery
+    return flashing || (starfield_fps > 0 && !redraw_on_change);
+}
 
-    if (hostname_override) {
-        strncpy(discovered_hosts[index].hostname, hostname_override, sizeof(discovered_hosts[index].hostname) - 1);
-    } else {
-        struct sockaddr_in sa;
-        sa.sin_family = AF_INET;
-        inet_pton(AF_INET, ip, &sa.sin_addr);
-        if (getnameinfo((struct sockaddr*)&sa, sizeof(sa), discovered_hosts[index].hostname, sizeof(discovered_hosts[index].hostname), NULL, 0, 0) != 0) {
-            strcpy(discovered_hosts[index].hostname, "N/A");
-        }
+// Handles one SDL event. Returns true when the window needs a redraw.
+bool handle_event(const SDL_Event* e) {
+    if (e->type == SDL_QUIT) {
+        app_is_running = false; // Signal threads to exit
+        return false;
+    } else if (e->type == SDL_MOUSEBUTTONDOWN) {
+        select_host_at(e->button.y);
+        return true;
+    } else if (e->type == SDL_MOUSEWHEEL) {
+        host_view_scroll(&host_view, -e->wheel.y * WHEEL_SCROLL_ROWS, host_list_rows);
+        return true;
+    } else if (e->type == SDL_KEYDOWN) {
+        return handle_key(e->key.keysym.sym);
+    } else if (e->type == redraw_event) {
+        __atomic_store_n(&redraw_pending, 0, __ATOMIC_RELEASE);
+        play_pending_alert();
+        return true;
     }
-
-    discovered_hosts_count++;
-    
-    pthread_mutex_unlock(&host_list_mutex);
+    return e->type == SDL_WINDOWEVENT;
 }
 
-void* discovery_worker(void* arg) {
-    DiscoveryThreadArgs* args = (DiscoveryThreadArgs*)arg;
-    for (int i = args->start_host; i <= args->end_host; i++) {
-        if (!app_is_running) break; // Allow early exit
-        char ip[16];
-        snprintf(ip, sizeof(ip), "%s%d", args->subnet, i);
-        for (int p = 0; p < NUM_COMMON_PORTS; p++) {
-            if (check_port(ip, COMMON_PORTS[p])) {
-                add_host_to_list(ip, NULL);
-                break; 
-            }
-        }
+// Scrolling, sort and filter keys. Returns true when the view changed.
+bool handle_key(SDL_Keycode key) {
+    int page = host_list_rows > 1 ? host_list_rows - 1 : 1;
+    switch (key) {
+        case SDLK_ESCAPE: selected_host = 0; break;
+        case SDLK_UP: host_view_scroll(&host_view, -1, host_list_rows); break;
+        case SDLK_DOWN: host_view_scroll(&host_view, 1, host_list_rows); break;
+        case SDLK_PAGEUP: host_view_scroll(&host_view, -page, host_list_rows); break;
+        case SDLK_PAGEDOWN: host_view_scroll(&host_view, page, host_list_rows); break;
+        case SDLK_HOME: host_view_scroll(&host_view, -host_view.row_count, host_list_rows); break;
+        case SDLK_END: host_view_scroll(&host_view, host_view.row_count, host_list_rows); break;
+        case SDLK_s: host_view_set_sort(&host_view, (HostSortKey)((host_view.sort_key + 1) % SORT_KEY_COUNT)); break;
+        case SDLK_f: host_view_set_filter(&host_view, (HostFilter)((host_view.filter + 1) % FILTER_COUNT)); break;
+#ifdef NETMON_TRACE
+        case SDLK_F3: show_trace_overlay = !show_trace_overlay; break;
+#endif
+        default: return false;
     }
-    free(args);
-    return NULL;
+    return true;
 }
 
-void* network_thread_main(void* arg) {
-    (void)arg;
-
-    // --- Phase 1: Detect Subnet and Discover Hosts ---
-    if (strlen(active_subnet) == 0) {
-        if (!get_local_ip_and_subnet(active_subnet, sizeof(active_subnet))) {
-            printf("Could not detect local subnet. Falling back to %s0/24\n", DEFAULT_SUBNET);
-            strncpy(active_subnet, DEFAULT_SUBNET, sizeof(active_subnet) - 1);
-        } else {
-            printf("Detected local subnet. Scanning %s0/24\n", active_subnet);
+// Draws the trace histograms over the top-right corner of the window.
+void render_trace_overlay(void) {
+#ifdef NETMON_TRACE
+    static const int columns[] = {0, 100, 180, 260, 340}; // Offsets of name, count, p50, p99, max
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color gray = {150, 150, 150, 255};
+    SDL_Rect box = {window_width - TRACE_OVERLAY_WIDTH - 10, 10, TRACE_OVERLAY_WIDTH, (TRACE_METRIC_COUNT + 1) * ROW_HEIGHT + 10};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 210);
+    SDL_RenderFillRect(renderer, &box);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    int x = box.x + 8, y = box.y + 5;
+    const char* headers[] = {"span (us)", "count", "p50", "p99", "max"};
+    for (int c = 0; c < 5; c++) render_text(headers[c], x + columns[c], y, gray);
+    for (int m = 0; m < TRACE_METRIC_COUNT; m++) {
+        y += ROW_HEIGHT;
+        TraceSummary summary;
+        trace_summarize((TraceMetric)m, &summary);
+        uint64_t values[] = {summary.count, summary.p50_us, summary.p99_us, summary.max_us};
+        render_text(trace_metric_name((TraceMetric)m), x, y, white);
+        for (int c = 0; c < 4; c++) {
+            char text[24];
+            snprintf(text, sizeof(text), "%llu", (unsigned long long)values[c]);
+            render_text(text, x + columns[c + 1], y, white);
         }
     }
+#endif
+}
 
-    pthread_t threads[NUM_THREADS];
-    int hosts_per_thread = (END_HOST - START_HOST + 1) / NUM_THREADS;
+// Draws a thumb on the right edge when the list is longer than the window.
+void render_scrollbar(int top, int bottom) {
+    if (host_view.row_count <= host_list_rows || host_list_rows <= 0) return;
+    int track = bottom - top;
+    int thumb = track * host_list_rows / host_view.row_count;
+    if (thumb < ROW_HEIGHT) thumb = ROW_HEIGHT;
+    int max_first = host_view.row_count - host_list_rows;
+    int thumb_y = top + (track - thumb) * host_view.first_row / max_first;
+    SDL_SetRenderDrawColor(renderer, 60, 75, 90, 255);
+    SDL_Rect track_rect = {window_width - SCROLLBAR_WIDTH - 2, top, SCROLLBAR_WIDTH, track};
+    SDL_RenderFillRect(renderer, &track_rect);
+    SDL_SetRenderDrawColor(renderer, 150, 150, 150, 255);
+    SDL_Rect thumb_rect = {window_width - SCROLLBAR_WIDTH - 2, thumb_y, SCROLLBAR_WIDTH, thumb};
+    SDL_RenderFillRect(renderer, &thumb_rect);
+}
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        DiscoveryThreadArgs* args = malloc(sizeof(DiscoveryThreadArgs));
-        strncpy(args->subnet, active_subnet, sizeof(args->subnet));
-        args->start_host = START_HOST + (i * hosts_per_thread);
-        args->end_host = (i == NUM_THREADS - 1) ? END_HOST : args->start_host + hosts_per_thread - 1;
+// Asks the UI thread for a redraw. Called from the network and resolver
+// threads; at most one SDL user event is queued at a time.
+void request_redraw(void) {
+    if (redraw_event == (Uint32)-1) return;
+    if (__atomic_exchange_n(&redraw_pending, 1, __ATOMIC_ACQ_REL)) return;
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = redraw_event;
+    SDL_PushEvent(&event);
+}
 
-        if (pthread_create(&threads[i], NULL, discovery_worker, args) != 0) {
-            perror("Failed to create discovery thread");
-            free(args);
-        }
+// Toggles the detail pane for the host row under y.
+void select_host_at(int y) {
+    if (y < host_list_top) return;
+    int row = (y - host_list_top) / ROW_HEIGHT;
+    if (row >= host_list_rows) return;
+    host_list_lock();
+    host_view_refresh(&host_view); // Rows hold table indices, so they must match the table as locked now
+    row += host_view.first_row;
+    if (row < host_view.row_count) {
+        uint32_t addr = discovered_hosts[host_view.rows[row]].addr;
+        selected_host = (selected_host == addr) ? 0 : addr;
     }
+    host_list_unlock();
+}
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], NULL);
-    }
-    
-    // --- Add Internet Check and Sort ---
-    add_host_to_list(INTERNET_CHECK_IP, "INTERNET");
-    pthread_mutex_lock(&host_list_mutex);
-    qsort(discovered_hosts, discovered_hosts_count, sizeof(MonitoredHost), compare_hosts);
-    pthread_mutex_unlock(&host_list_mutex);
-
-    discovery_complete = true;
-
-    // --- Phase 2: Monitoring ---
-    while (app_is_running) { // FIX: Check the global running flag
-        pthread_mutex_lock(&host_list_mutex);
-        for (int i = 0; i < discovered_hosts_count; i++) {
-            bool is_online = false;
-            for (int p = 0; p < NUM_COMMON_PORTS; p++) {
-                if (check_port(discovered_hosts[i].ip, COMMON_PORTS[p])) {
-                    is_online = true;
-                    break;
-                }
-            }
-
-            HostStatus old_status = discovered_hosts[i].status;
-            if (is_online) {
-                discovered_hosts[i].status = STATUS_UP;
-                discovered_hosts[i].consecutive_failures = 0;
-            } else {
-                discovered_hosts[i].consecutive_failures++;
-                if (discovered_hosts[i].consecutive_failures >= PING_FAIL_THRESHOLD) {
-                    if (discovered_hosts[i].status != STATUS_DOWN) {
-                        Mix_PlayChannel(-1, alert_sound, 0);
-                    }
-                    discovered_hosts[i].status = STATUS_DOWN;
-                } else {
-                    discovered_hosts[i].status = STATUS_UNSTABLE;
-                }
-            }
-            if (old_status != discovered_hosts[i].status) {
-                discovered_hosts[i].flash_timer = 1.0f;
-            }
-        }
-        pthread_mutex_unlock(&host_list_mutex);
-        
-        // Sleep for the interval, but check the running flag periodically for faster shutdown
-        for (int i = 0; i < MONITOR_INTERVAL_S * 10; i++) {
-            if (!app_is_running) break;
-#ifdef _WIN32
-            Sleep(100);
-#else
-            usleep(100000);
-#endif
-        }
+// Draws the detail pane from top to the bottom of the window. Its timeline
+// joins the frame's sparkline batch. Caller holds host_list_mutex.
+void render_host_detail(const MonitoredHost* host, int top) {
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color gray = {150, 150, 150, 255};
+    SDL_Rect pane = {0, top, window_width, window_height - top};
+    SDL_SetRenderDrawColor(renderer, 30, 42, 56, 255);
+    SDL_RenderFillRect(renderer, &pane);
+    SDL_SetRenderDrawColor(renderer, 90, 110, 130, 255);
+    SDL_RenderDrawLine(renderer, 0, top, window_width, top);
+
+    const HostDetail* detail = host_detail(host->detail);
+    char buffer[320];
+    char ip[HOST_ADDR_STRLEN];
+    int y = top + 6;
+    format_host_addr(host->addr, ip, sizeof(ip));
+    snprintf(buffer, sizeof(buffer), "%s  %s  %s", ip, host->hostname, host_status_name(host->status));
+    render_text(buffer, 10, y, white);
+    y += FONT_SIZE + 4;
+
+    RttStats rtt;
+    rtt_compute_stats(&detail->rtt, &rtt);
+    if (rtt.count > 0) {
+        snprintf(buffer, sizeof(buffer), "RTT last %.1f  min %.1f  avg %.1f  p95 %.1f  jitter %.1f ms  (%d samples)",
+                 rtt.last_us / 1000.0, rtt.min_us / 1000.0, rtt.avg_us / 1000.0, rtt.p95_us / 1000.0, rtt.jitter_us / 1000.0, rtt.count);
+    } else {
+        snprintf(buffer, sizeof(buffer), "No answered probes yet");
     }
-    return NULL;
+    render_text(buffer, 10, y, gray);
+    y += FONT_SIZE + 4;
+
+    int span_minutes = (int)((int64_t)RTT_TIMELINE * RTT_TIMELINE_SPAN * monitor_interval_ms / 60000);
+    snprintf(buffer, sizeof(buffer), "Last %d min, red = no answer. Esc closes.", span_minutes);
+    render_text(buffer, 10, y, gray);
+    y += FONT_SIZE + 4;
+
+    SDL_Rect timeline_area = {10, y, window_width - 20, window_height - y - 6};
+    sparkline_add_timeline(&sparklines, &detail->timeline, timeline_area, (SDL_Color){96, 165, 250, 255}, (SDL_Color){239, 68, 68, 140});
 }
 
+// Runs on the event dispatch thread with an already coalesced and rate-limited
+// alert. Only records it; the UI thread plays the sound in play_pending_alert().
+void on_alert(const AlertSummary* summary) {
+    char text[96];
+    alert_summary_describe(summary, text, sizeof(text));
+    time_t now = time(NULL);
+    char clock[12];
+    strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&now));
+
+    pthread_mutex_lock(&alert_mutex);
+    snprintf(last_alert, sizeof(last_alert), "%s  %s", clock, text);
+    pthread_mutex_unlock(&alert_mutex);
+    __atomic_store_n(&alert_pending, 1, __ATOMIC_RELEASE);
+    request_redraw();
+}
+
+// Plays the alert sound if on_alert() queued one. UI thread only.
+void play_pending_alert(void) {
+    if (__atomic_exchange_n(&alert_pending, 0, __ATOMIC_ACQ_REL)) Mix_PlayChannel(-1, alert_sound, 0);
+}
 
 // --- SDL and System Functions ---
 bool init_sdl() {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) return false;
     if (TTF_Init() == -1) return false;
     if (Mix_OpenAudio(SAMPLE_RATE, MIX_DEFAULT_FORMAT, 2, 2048) < 0) return false;
-    window = SDL_CreateWindow("Network Host Monitor", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    window = SDL_CreateWindow("Network Host Monitor", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     if (!window) return false;
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     if (!renderer) return false;
     return true;
 }
 
+// Fills the static sample buffer once. The chunk references it, so it must
+// outlive alert_sound; freeing the old heap copy right away left the mixer
+// playing from released memory.
 void create_alert_sound() {
-    int sound_len = SAMPLE_RATE / 4;
-    Sint16* data = malloc(sound_len * sizeof(Sint16));
-    if (!data) return;
-
-    for (int i = 0; i < sound_len; ++i) {
+    for (int i = 0; i < ALERT_SAMPLES; ++i) {
         double time = (double)i / SAMPLE_RATE;
-        if (time < 0.1) data[i] = (Sint16)(4000 * sin(2.0 * M_PI * 880.0 * time));
-        else if (time < 0.15) data[i] = 0;
-        else data[i] = (Sint16)(4000 * sin(2.0 * M_PI * 660.0 * time));
+        if (time < 0.1) alert_samples[i] = (Sint16)(4000 * sin(2.0 * M_PI * 880.0 * time));
+        else if (time < 0.15) alert_samples[i] = 0;
+        else alert_samples[i] = (Sint16)(4000 * sin(2.0 * M_PI * 660.0 * time));
     }
 
-    alert_sound = Mix_QuickLoad_RAW((Uint8*)data, sound_len * sizeof(Sint16));
-    free(data);
+    alert_sound = Mix_QuickLoad_RAW((Uint8*)alert_samples, sizeof(alert_samples));
 }
 
+// Everything comes from memory: the font from font.h, the alert from
+// create_alert_sound(). Startup reads no files.
 bool load_media() {
-    font = TTF_OpenFont("font.ttf", FONT_SIZE);
+    SDL_RWops* font_data = SDL_RWFromConstMem(font_ttf, (int)font_ttf_len);
+    font = font_data ? TTF_OpenFontRW(font_data, 1, FONT_SIZE) : NULL; // 1: TTF closes font_data
     if (!font) {
-        printf("Failed to load font! TTF_Error: %s\nPlease provide 'font.ttf'.\n", TTF_GetError());
+        printf("Failed to load the embedded font! TTF_Error: %s\n", TTF_GetError());
         return false;
     }
     create_alert_sound();
@@ -448,18 +632,16 @@ bool load_media() {
 }
 
 void cleanup() {
-    free(discovered_hosts);
     if (alert_sound) Mix_FreeChunk(alert_sound);
     if (font) TTF_CloseFont(font);
+    text_cache_clear();
+    sparkline_batch_free(&sparklines);
+    host_view_free(&host_view);
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
     Mix_Quit();
     TTF_Quit();
     SDL_Quit();
-
-#ifdef _WIN32
-    WSACleanup();
-#endif
 }
 
 // --- Utility Functions ---
@@ -469,170 +651,73 @@ void init_stars() {
         stars[i].y = (rand() % SCREEN_HEIGHT) - (SCREEN_HEIGHT / 2);
         stars[i].z = rand() % (SCREEN_WIDTH / 2);
     }
+    // Quad q always uses vertices 4q..4q+3, so the index list never changes
+    for (int q = 0; q < NUM_STARS; q++) {
+        int* idx = &star_indices[q * 6];
+        idx[0] = q * 4; idx[1] = q * 4 + 1; idx[2] = q * 4 + 2;
+        idx[3] = q * 4; idx[4] = q * 4 + 2; idx[5] = q * 4 + 3;
+    }
 }
 
-void update_and_render_stars() {
+// Moves the stars by elapsed time and rebuilds the quads of the visible ones.
+void update_stars(float seconds) {
+    star_vertex_count = 0;
     for (int i = 0; i < NUM_STARS; i++) {
-        stars[i].z -= 0.5f;
+        stars[i].z -= STAR_SPEED * seconds;
 
         if (stars[i].z <= 0) {
-            stars[i].x = (rand() % SCREEN_WIDTH) - (SCREEN_WIDTH / 2);
-            stars[i].y = (rand() % SCREEN_HEIGHT) - (SCREEN_HEIGHT / 2);
+            stars[i].x = (rand() % window_width) - (window_width / 2);
+            stars[i].y = (rand() % window_height) - (window_height / 2);
             stars[i].z = (SCREEN_WIDTH / 2);
         }
 
         float k = 128.0f / stars[i].z;
-        int sx = (int)(stars[i].x * k + SCREEN_WIDTH / 2);
-        int sy = (int)(stars[i].y * k + SCREEN_HEIGHT / 2);
-
-        if (sx > 0 && sx < SCREEN_WIDTH && sy > 0 && sy < SCREEN_HEIGHT) {
-            float size = (1.0f - stars[i].z / (SCREEN_WIDTH / 2.0f)) * 3.0f;
-            Uint8 color = (Uint8)((1.0f - stars[i].z / (SCREEN_WIDTH / 2.0f)) * 150);
-            SDL_SetRenderDrawColor(renderer, color, color, color, 255);
-            SDL_Rect star_rect = {sx, sy, (int)size, (int)size};
-            SDL_RenderFillRect(renderer, &star_rect);
+        int sx = (int)(stars[i].x * k + window_width / 2);
+        int sy = (int)(stars[i].y * k + window_height / 2);
+        int size = (int)((1.0f - stars[i].z / (SCREEN_WIDTH / 2.0f)) * 3.0f);
+        if (sx <= 0 || sx >= window_width || sy <= 0 || sy >= window_height || size <= 0) continue;
+
+        Uint8 shade = (Uint8)((1.0f - stars[i].z / (SCREEN_WIDTH / 2.0f)) * 150);
+        SDL_Color color = {shade, shade, shade, 255};
+        SDL_Vertex* v = &star_vertices[star_vertex_count];
+        v[0].position = (SDL_FPoint){(float)sx, (float)sy};
+        v[1].position = (SDL_FPoint){(float)(sx + size), (float)sy};
+        v[2].position = (SDL_FPoint){(float)(sx + size), (float)(sy + size)};
+        v[3].position = (SDL_FPoint){(float)sx, (float)(sy + size)};
+        for (int c = 0; c < 4; c++) {
+            v[c].color = color;
+            v[c].tex_coord = (SDL_FPoint){0.0f, 0.0f};
         }
+        star_vertex_count += 4;
     }
 }
 
-
-void render_text(const char* text, int x, int y, SDL_Color color) {
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_Rect rect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(renderer, texture, NULL, &rect);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-}
-
-int compare_hosts(const void* a, const void* b) {
-    const MonitoredHost* host_a = (const MonitoredHost*)a;
-    const MonitoredHost* host_b = (const MonitoredHost*)b;
-    // Special case for INTERNET to always be at the bottom
-    if (strcmp(host_a->hostname, "INTERNET") == 0) return 1;
-    if (strcmp(host_b->hostname, "INTERNET") == 0) return -1;
-    
-    // Convert full IP to integer for proper sorting
-    struct in_addr addr_a, addr_b;
-    inet_pton(AF_INET, host_a->ip, &addr_a);
-    inet_pton(AF_INET, host_b->ip, &addr_b);
-
-    if (addr_a.s_addr < addr_b.s_addr) return -1;
-    if (addr_a.s_addr > addr_b.s_addr) return 1;
-    return 0;
-}
-
-// --- Dynamic Subnet Detection ---
-bool get_local_ip_and_subnet(char* subnet_buffer, size_t buffer_size) {
-#ifdef _WIN32
-    PIP_ADAPTER_ADDRESSES pAddresses = NULL;
-    ULONG outBufLen = 15000;
-    DWORD dwRetVal = 0;
-    char ipstringbuffer[48];
-
-    pAddresses = (IP_ADAPTER_ADDRESSES*)malloc(outBufLen);
-    if (!pAddresses) return false;
-
-    dwRetVal = GetAdaptersAddresses(AF_INET, GAA_FLAG_INCLUDE_PREFIX, NULL, pAddresses, &outBufLen);
-    if (dwRetVal == NO_ERROR) {
-        for (PIP_ADAPTER_ADDRESSES pCurrAddresses = pAddresses; pCurrAddresses != NULL; pCurrAddresses = pCurrAddresses->Next) {
-            if (pCurrAddresses->IfType == IF_TYPE_ETHERNET_CSMACD || pCurrAddresses->IfType == IF_TYPE_IEEE80211) {
-                if (pCurrAddresses->FirstUnicastAddress != NULL) {
-                    LPSOCKADDR sockaddr_ip = pCurrAddresses->FirstUnicastAddress->Address.lpSockaddr;
-                    if (sockaddr_ip->sa_family == AF_INET) {
-                        struct sockaddr_in* addr_in = (struct sockaddr_in*)sockaddr_ip;
-                        inet_ntop(AF_INET, &addr_in->sin_addr, ipstringbuffer, sizeof(ipstringbuffer));
-                        char* last_dot = strrchr(ipstringbuffer, '.');
-                        if (last_dot) {
-                            size_t subnet_len = last_dot - ipstringbuffer + 1;
-                            if (subnet_len < buffer_size) {
-                                strncpy(subnet_buffer, ipstringbuffer, subnet_len);
-                                subnet_buffer[subnet_len] = '\0';
-                                free(pAddresses);
-                                return true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+// Draws the whole starfield in one SDL_RenderGeometry call. Positions only
+// advance starfield_fps times a second; frames in between redraw the same quads.
+void update_and_render_stars() {
+    if (starfield_fps <= 0) return;
+
+    Uint32 now = SDL_GetTicks();
+    Uint32 elapsed = now - stars_updated_at;
+    // In on-change mode the field is drawn but stands still
+    if (!stars_built || (!redraw_on_change && elapsed >= 1000u / (Uint32)starfield_fps)) {
+        // Clamp so a stall does not throw every star across the screen
+        float seconds = !stars_built ? 0.0f : (elapsed > 250 ? 0.25f : elapsed / 1000.0f);
+        update_stars(seconds);
+        stars_updated_at = now;
+        stars_built = true;
     }
-    free(pAddresses);
-    return false;
-#else // Linux/macOS
-    struct ifaddrs *ifaddr, *ifa;
-    char host[NI_MAXHOST];
-
-    if (getifaddrs(&ifaddr) == -1) return false;
-
-    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-        if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET) continue;
-        
-        if (strncmp(ifa->ifa_name, "en", 2) == 0 || strncmp(ifa->ifa_name, "eth", 3) == 0 || strncmp(ifa->ifa_name, "wl", 2) == 0) {
-            if (getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in), host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST) == 0) {
-                char* last_dot = strrchr(host, '.');
-                if (last_dot) {
-                    size_t subnet_len = last_dot - host + 1;
-                    if (subnet_len < buffer_size) {
-                        strncpy(subnet_buffer, host, subnet_len);
-                        subnet_buffer[subnet_len] = '\0';
-                        freeifaddrs(ifaddr);
-                        return true;
-                    }
-                }
-            }
-        }
+    if (star_vertex_count > 0) {
+        SDL_RenderGeometry(renderer, NULL, star_vertices, star_vertex_count, star_indices, star_vertex_count / 4 * 6);
     }
-    freeifaddrs(ifaddr);
-    return false;
-#endif
 }
 
 
-// --- Networking Logic (from previous scanner) ---
-bool check_port(const char* ip, int port) {
-    int sock;
-    struct sockaddr_in server_addr;
-
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) return false;
-
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    inet_pton(AF_INET, ip, &server_addr.sin_addr);
-
-#ifdef _WIN32
-    u_long mode = 1;
-    if (ioctlsocket(sock, FIONBIO, &mode) != 0) { closesocket(sock); return false; }
-#else
-    if (fcntl(sock, F_SETFL, O_NONBLOCK) < 0) { close(sock); return false; }
-#endif
-
-    connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    
-    fd_set fdset;
-    struct timeval tv;
-    FD_ZERO(&fdset);
-    FD_SET(sock, &fdset);
-    tv.tv_sec = 0;
-    tv.tv_usec = CONNECT_TIMEOUT_MS * 1000;
-
-    if (select(sock + 1, NULL, &fdset, NULL, &tv) == 1) {
-        int so_error;
-        socklen_t len = sizeof(so_error);
-        getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
-#ifdef _WIN32
-        closesocket(sock);
-#else
-        close(sock);
-#endif
-        return so_error == 0;
-    }
-
-#ifdef _WIN32
-    closesocket(sock);
-#else
-    close(sock);
-#endif
-    return false;
+void render_text(const char* text, int x, int y, SDL_Color color) {
+    int w, h;
+    SDL_Texture* texture = text_cache_get(renderer, font, text, color, &w, &h);
+    if (!texture) return;
+    SDL_Rect rect = {x, y, w, h};
+    SDL_RenderCopy(renderer, texture, NULL, &rect);
 }
+#endif
@@ -0,0 +1,322 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "metrics.h"
+#include "netutil.h"
+#include "hostaddr.h"
+#include "probe.h"
+#include "timeutil.h"
+
+#define METRICS_POLL_MS 200 // How often the server thread checks for shutdown
+#define METRICS_REQUEST_MAX 2048
+
+// What a scrape sees of one host; copied from MonitoredHost at publish time.
+typedef struct {
+    char ip[HOST_ADDR_STRLEN];
+    const char* hostname; // Interned, so it outlives the server thread
+    HostStatus status;
+    int consecutive_failures;
+    uint32_t probes_total;
+    uint32_t failures_total;
+    RttHistory rtt; // Statistics are computed at scrape time, off the network thread
+} MetricsHost;
+
+typedef struct {
+    MetricsHost* hosts;
+    int count;
+    int capacity;
+    double probes_per_second; // Launch rate since the previous snapshot
+} MetricsSnapshot;
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} MetricsBuffer;
+
+static char listen_host[256] = "";
+static char listen_port[8] = "";
+static net_socket_t listen_socket = NET_INVALID_SOCKET;
+static pthread_t server_thread;
+static bool server_started = false;
+static volatile bool server_running = false;
+
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER; // Held by a scrape while it formats
+static MetricsSnapshot snapshot = {NULL, 0, 0, 0.0};
+static uint64_t published_at_ms = 0; // Guarded by host_list_mutex, like the publisher itself
+static uint64_t published_probes = 0;
+
+bool metrics_set_listen(const char* spec) {
+    return parse_host_port(spec, false, listen_host, sizeof(listen_host), listen_port, sizeof(listen_port));
+}
+
+bool metrics_enabled(void) {
+    return listen_port[0] != '\0';
+}
+
+// --- Snapshot ---
+void metrics_publish_if_due(const MonitoredHost* hosts, int count) {
+    if (!server_running) return;
+    uint64_t now = monotonic_ms();
+    if (published_at_ms != 0 && now - published_at_ms < METRICS_PUBLISH_MS) return;
+    // A scrape is formatting the current snapshot; try again on the next batch
+    if (pthread_mutex_trylock(&snapshot_mutex) != 0) return;
+
+    if (count > snapshot.capacity) {
+        int capacity = snapshot.capacity ? snapshot.capacity : 256;
+        while (capacity < count) capacity *= 2;
+        MetricsHost* grown = realloc(snapshot.hosts, capacity * sizeof(MetricsHost));
+        if (!grown) {
+            pthread_mutex_unlock(&snapshot_mutex);
+            return;
+        }
+        snapshot.hosts = grown;
+        snapshot.capacity = capacity;
+    }
+    for (int i = 0; i < count; i++) {
+        MetricsHost* out = &snapshot.hosts[i];
+        const HostDetail* detail = host_detail(hosts[i].detail);
+        format_host_addr(hosts[i].addr, out->ip, sizeof(out->ip));
+        out->hostname = hosts[i].hostname;
+        out->status = hosts[i].status;
+        out->consecutive_failures = hosts[i].consecutive_failures;
+        out->probes_total = detail->probes_total;
+        out->failures_total = detail->failures_total;
+        out->rtt = detail->rtt;
+    }
+    snapshot.count = count;
+
+    uint64_t probes = probe_total_launched();
+    if (published_at_ms != 0) {
+        snapshot.probes_per_second = (double)(probes - published_probes) * 1000.0 / (double)(now - published_at_ms);
+    }
+    published_probes = probes;
+    published_at_ms = now;
+    pthread_mutex_unlock(&snapshot_mutex);
+}
+
+// --- Exposition Format ---
+static void buffer_printf(MetricsBuffer* buffer, const char* format, ...) {
+    for (;;) {
+        size_t room = buffer->capacity - buffer->len;
+        va_list args;
+        va_start(args, format);
+        int written = buffer->data ? vsnprintf(buffer->data + buffer->len, room, format, args) : -1;
+        va_end(args);
+        if (written >= 0 && (size_t)written < room) {
+            buffer->len += (size_t)written;
+            return;
+        }
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 65536;
+        if (written >= 0 && capacity < buffer->len + (size_t)written + 1) capacity = buffer->len + (size_t)written + 1;
+        char* grown = realloc(buffer->data, capacity);
+        if (!grown) return; // Drop the line; the scrape still gets the rest
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+}
+
+// Label values escape backslash, quote and newline, per the text format.
+static void escape_label(const char* value, char* out, size_t size) {
+    size_t n = 0;
+    for (const char* c = value; *c && n + 2 < size; c++) {
+        if (*c == '\\' || *c == '"') {
+            out[n++] = '\\';
+            out[n++] = *c;
+        } else if (*c == '\n') {
+            out[n++] = '\\';
+            out[n++] = 'n';
+        } else {
+            out[n++] = *c;
+        }
+    }
+    out[n] = '\0';
+}
+
+static void format_help(MetricsBuffer* out, const char* name, const char* type, const char* help) {
+    buffer_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Per-host metric families. RTT families are skipped for hosts with no samples.
+typedef struct {
+    const char* name;
+    const char* type;
+    const char* help;
+    bool needs_rtt;
+    double (*value)(const MetricsHost* host, const RttStats* rtt);
+} HostFamily;
+
+static double host_up(const MetricsHost* host, const RttStats* rtt) { (void)rtt; return host->status != STATUS_DOWN && host->consecutive_failures == 0; }
+static double host_status(const MetricsHost* host, const RttStats* rtt) { (void)rtt; return host->status; }
+static double host_failures(const MetricsHost* host, const RttStats* rtt) { (void)rtt; return host->consecutive_failures; }
+static double host_probes(const MetricsHost* host, const RttStats* rtt) { (void)rtt; return host->probes_total; }
+static double host_probe_failures(const MetricsHost* host, const RttStats* rtt) { (void)rtt; return host->failures_total; }
+static double host_rtt_last(const MetricsHost* host, const RttStats* rtt) { (void)host; return rtt->last_us / 1e6; }
+static double host_rtt_avg(const MetricsHost* host, const RttStats* rtt) { (void)host; return rtt->avg_us / 1e6; }
+static double host_rtt_p95(const MetricsHost* host, const RttStats* rtt) { (void)host; return rtt->p95_us / 1e6; }
+static double host_rtt_jitter(const MetricsHost* host, const RttStats* rtt) { (void)host; return rtt->jitter_us / 1e6; }
+
+static const HostFamily host_families[] = {
+    {"netmonitor_host_up", "gauge", "1 when the host answered its latest monitoring round.", false, host_up},
+    {"netmonitor_host_status", "gauge", "Host status: 0 scanning, 1 up, 2 unstable, 3 down.", false, host_status},
+    {"netmonitor_host_consecutive_failures", "gauge", "Monitoring rounds without an answer in a row.", false, host_failures},
+    {"netmonitor_host_probes_total", "counter", "Monitoring rounds since the host was discovered.", false, host_probes},
+    {"netmonitor_host_probe_failures_total", "counter", "Monitoring rounds in which no probe method got an answer.", false, host_probe_failures},
+    {"netmonitor_host_rtt_last_seconds", "gauge", "Latest answered probe round-trip time.", true, host_rtt_last},
+    {"netmonitor_host_rtt_avg_seconds", "gauge", "Mean of the recent round-trip times.", true, host_rtt_avg},
+    {"netmonitor_host_rtt_p95_seconds", "gauge", "95th percentile of the recent round-trip times.", true, host_rtt_p95},
+    {"netmonitor_host_rtt_jitter_seconds", "gauge", "Mean difference between consecutive round-trip times.", true, host_rtt_jitter},
+};
+
+static void format_metrics(MetricsBuffer* out) {
+    out->len = 0;
+    pthread_mutex_lock(&snapshot_mutex);
+
+    int by_status[4] = {0, 0, 0, 0};
+    for (int i = 0; i < snapshot.count; i++) by_status[snapshot.hosts[i].status]++;
+    format_help(out, "netmonitor_hosts", "gauge", "Monitored hosts by status.");
+    for (int s = STATUS_SCANNING; s <= STATUS_DOWN; s++) {
+        buffer_printf(out, "netmonitor_hosts{status=\"%s\"} %d\n", host_status_name((HostStatus)s), by_status[s]);
+    }
+
+    // Every family is written out whole before the next, as the format requires
+    for (size_t f = 0; f < sizeof(host_families) / sizeof(host_families[0]); f++) {
+        const HostFamily* family = &host_families[f];
+        format_help(out, family->name, family->type, family->help);
+        for (int i = 0; i < snapshot.count; i++) {
+            const MetricsHost* host = &snapshot.hosts[i];
+            if (family->needs_rtt && host->rtt.count == 0) continue; // No RTT yet is absent, not zero
+            RttStats rtt;
+            if (family->needs_rtt) rtt_compute_stats(&host->rtt, &rtt);
+            char hostname[512];
+            escape_label(host->hostname, hostname, sizeof(hostname));
+            buffer_printf(out, "%s{ip=\"%s\",hostname=\"%s\"} %.9g\n", family->name, host->ip, hostname, family->value(host, &rtt));
+        }
+    }
+    double probes_per_second = snapshot.probes_per_second;
+    pthread_mutex_unlock(&snapshot_mutex);
+
+    // Scanner internals are atomics, read live rather than from the snapshot
+    format_help(out, "netmonitor_probes_total", "counter", "Connects and packets sent by every probe method.");
+    buffer_printf(out, "netmonitor_probes_total %llu\n", (unsigned long long)probe_total_launched());
+    format_help(out, "netmonitor_probes_per_second", "gauge", "Probe launch rate over the last snapshot interval.");
+    buffer_printf(out, "netmonitor_probes_per_second %.3f\n", probes_per_second);
+    format_help(out, "netmonitor_connects_in_flight", "gauge", "TCP connects currently open.");
+    buffer_printf(out, "netmonitor_connects_in_flight %d\n", probe_connects_in_flight());
+    format_help(out, "netmonitor_discovery_duration_seconds", "gauge", "Length of the discovery sweep, 0 while it runs.");
+    buffer_printf(out, "netmonitor_discovery_duration_seconds %.6f\n", __atomic_load_n(&monitor_stats.discovery_us, __ATOMIC_RELAXED) / 1e6);
+    format_help(out, "netmonitor_probe_batches_total", "counter", "Monitoring batches probed and published.");
+    buffer_printf(out, "netmonitor_probe_batches_total %llu\n", (unsigned long long)__atomic_load_n(&monitor_stats.batches, __ATOMIC_RELAXED));
+    format_help(out, "netmonitor_probe_batch_duration_seconds", "gauge", "Duration of the latest monitoring batch.");
+    buffer_printf(out, "netmonitor_probe_batch_duration_seconds %.6f\n", __atomic_load_n(&monitor_stats.last_batch_us, __ATOMIC_RELAXED) / 1e6);
+    format_help(out, "netmonitor_host_lock_acquisitions_total", "counter", "Times the host table lock was taken.");
+    buffer_printf(out, "netmonitor_host_lock_acquisitions_total %llu\n", (unsigned long long)__atomic_load_n(&monitor_stats.lock_acquisitions, __ATOMIC_RELAXED));
+    format_help(out, "netmonitor_host_lock_contended_total", "counter", "Times the host table lock had to be waited for.");
+    buffer_printf(out, "netmonitor_host_lock_contended_total %llu\n", (unsigned long long)__atomic_load_n(&monitor_stats.lock_contended, __ATOMIC_RELAXED));
+    format_help(out, "netmonitor_host_lock_wait_seconds_total", "counter", "Time spent waiting for the host table lock.");
+    buffer_printf(out, "netmonitor_host_lock_wait_seconds_total %.6f\n", __atomic_load_n(&monitor_stats.lock_wait_us, __ATOMIC_RELAXED) / 1e6);
+}
+
+// --- HTTP Server ---
+static void send_all(net_socket_t sock, const char* data, size_t len) {
+    while (len > 0) {
+        int sent = send(sock, data, (int)len, NET_SEND_FLAGS);
+        if (sent <= 0) return;
+        data += sent;
+        len -= (size_t)sent;
+    }
+}
+
+static void send_response(net_socket_t sock, const char* status, const char* content_type, const char* body, size_t body_len) {
+    char header[256];
+    int len = snprintf(header, sizeof(header), "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n",
+                       status, content_type, (unsigned long)body_len);
+    send_all(sock, header, (size_t)len);
+    send_all(sock, body, body_len);
+}
+
+// Reads the request head and answers it. One client at a time; a scrape
+// every few seconds does not need more.
+static void serve_client(net_socket_t client, MetricsBuffer* body) {
+    char request[METRICS_REQUEST_MAX];
+    size_t len = 0;
+    uint64_t deadline = monotonic_ms() + METRICS_REQUEST_TIMEOUT_MS;
+    while (len < sizeof(request) - 1) {
+        uint64_t now = monotonic_ms();
+        if (now >= deadline || !net_wait(client, false, (int)(deadline - now))) return;
+        int got = recv(client, request + len, (int)(sizeof(request) - 1 - len), 0);
+        if (got <= 0) return;
+        len += (size_t)got;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[len] = '\0';
+
+    if (strncmp(request, "GET ", 4) != 0) {
+        const char* message = "Only GET is supported\n";
+        send_response(client, "405 Method Not Allowed", "text/plain", message, strlen(message));
+        return;
+    }
+    const char* path = request + 4;
+    size_t path_len = strcspn(path, " ?\r\n");
+    if (path_len != 8 || strncmp(path, "/metrics", 8) != 0) {
+        const char* message = "Not found; metrics are at /metrics\n";
+        send_response(client, "404 Not Found", "text/plain", message, strlen(message));
+        return;
+    }
+    format_metrics(body);
+    send_response(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body->data ? body->data : "", body->len);
+}
+
+static void* metrics_thread_main(void* arg) {
+    (void)arg;
+    MetricsBuffer body = {NULL, 0, 0}; // Reused between scrapes
+    while (server_running) {
+        if (!net_wait(listen_socket, false, METRICS_POLL_MS)) continue;
+        net_socket_t client = accept(listen_socket, NULL, NULL);
+        if (client == NET_INVALID_SOCKET) continue;
+        net_no_sigpipe(client);
+        serve_client(client, &body);
+        net_close_socket(client);
+    }
+    free(body.data);
+    return NULL;
+}
+
+bool metrics_start(void) {
+    if (!metrics_enabled()) return true;
+
+    listen_socket = open_listener(listen_host, listen_port, 8, "metrics");
+    if (listen_socket == NET_INVALID_SOCKET) return false;
+
+    server_running = true;
+    if (pthread_create(&server_thread, NULL, metrics_thread_main, NULL) != 0) {
+        perror("Failed to create metrics thread");
+        server_running = false;
+        net_close_socket(listen_socket);
+        listen_socket = NET_INVALID_SOCKET;
+        return false;
+    }
+    server_started = true;
+    printf("Serving metrics on http://%s:%s/metrics\n", listen_host[0] ? listen_host : "*", listen_port);
+    return true;
+}
+
+void metrics_stop(void) {
+    if (!server_started) return;
+    server_running = false;
+    pthread_join(server_thread, NULL);
+    server_started = false;
+    net_close_socket(listen_socket);
+    listen_socket = NET_INVALID_SOCKET;
+
+    pthread_mutex_lock(&snapshot_mutex);
+    free(snapshot.hosts);
+    snapshot.hosts = NULL;
+    snapshot.count = snapshot.capacity = 0;
+    pthread_mutex_unlock(&snapshot_mutex);
+}
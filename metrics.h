@@ -0,0 +1,31 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+
+#include "monitor.h"
+
+// --- Prometheus Metrics Endpoint ---
+// A small HTTP server on its own thread answers GET /metrics in the
+// Prometheus text format. Scrapes only ever read a snapshot that the network
+// thread publishes about once a second while it holds host_list_mutex; the
+// server never touches the live host table, and publishing skips a round
+// rather than wait for a scrape in progress.
+
+#define METRICS_PUBLISH_MS 1000 // Snapshot refresh interval
+#define METRICS_REQUEST_TIMEOUT_MS 2000 // Slow clients are dropped after this
+
+bool metrics_set_listen(const char* spec); // "PORT" (all interfaces) or "HOST:PORT"
+bool metrics_enabled(void);
+
+// Binds the listener and starts the server thread. On Windows it must run
+// after WSAStartup(). Returns true without doing anything when disabled.
+bool metrics_start(void);
+
+// Copies the host table into the snapshot if METRICS_PUBLISH_MS has passed.
+// Caller holds host_list_mutex. Cheap no-op when metrics are disabled.
+void metrics_publish_if_due(const MonitoredHost* hosts, int count);
+
+void metrics_stop(void);
+
+#endif
@@ -0,0 +1,1050 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "monitor.h"
+#include "hostaddr.h"
+#include "neighbor.h"
+#include "options.h"
+#include "notify.h"
+#include "probe.h"
+#include "resolver.h"
+#include "scheduler.h"
+#include "timeutil.h"
+#include "metrics.h"
+#include "inventory.h"
+#include "events.h"
+#include "arena.h"
+#include "agent.h"
+#include "collector.h"
+#include "trace.h"
+
+// --- Globals ---
+MonitoredHost* discovered_hosts = NULL;
+HostDetail** host_detail_chunks = NULL; // Chunk n holds slots n * HOST_DETAIL_CHUNK onwards
+StringArena host_names = {NULL, NULL, 0, 0};
+int discovered_hosts_count = 0;
+int discovered_hosts_capacity = 0;
+HostIndex host_index = {NULL, NULL, 0, 0}; // addr -> detail slot; host_row() finds the row
+static uint32_t internet_check_addr = 0; // INTERNET_CHECK_IP, packed
+bool discovery_complete = false;
+volatile bool rediscovery_active = false;
+TargetSpec scan_targets = {NULL, 0, 0}; // Address ranges to discover
+char active_subnet[64] = ""; // Short description of scan_targets for display
+StatusChangeHook status_change_hook = NULL;
+HostTableHook host_table_hook = NULL;
+
+pthread_mutex_t host_list_mutex = PTHREAD_MUTEX_INITIALIZER; // Static, so the collector can merge before the network thread runs
+unsigned int host_table_version = 0;
+volatile bool app_is_running = true; // FIX: Global flag for graceful thread shutdown
+MonitorStats monitor_stats = {0, 0, 0, 0, 0, 0};
+
+static pthread_t network_thread;
+static pthread_t rediscovery_thread;
+static bool rediscovery_started = false;
+static pthread_mutex_t rediscovery_mutex = PTHREAD_MUTEX_INITIALIZER; // Sleep between sweeps
+static pthread_cond_t rediscovery_cond = PTHREAD_COND_INITIALIZER; // Signalled by monitor_stop()
+// While a sweep runs beside monitoring, the two split probe_concurrency so
+// together they stay inside the descriptor budget.
+static volatile int monitor_window = 0; // Connects each monitoring batch may keep open
+static unsigned int hosts_inserted = 0; // Guarded by host_list_mutex; tells a sweep what it found
+
+// Detail slots, guarded by host_list_mutex. Slots of removed hosts go on a
+// free list sized for every slot, so freeing one never needs memory.
+static uint32_t detail_slots = 0; // Slots handed out so far
+static uint32_t* free_details = NULL;
+static uint32_t free_detail_count = 0;
+
+// Scratch for one probe batch (network thread) and one sweep (whichever
+// thread runs it; sweeps never overlap). Reset at the start of each round.
+static Arena batch_arena = {NULL};
+static Arena sweep_arena = {NULL};
+
+// Per-batch answers collected by on_monitor_result, indexed by probe group.
+typedef struct {
+    bool* answered;
+    uint16_t* open_port; // TCP port that answered, 0 for ICMP and ARP or no answer
+    uint32_t* rtt_us;    // RTT of the answering probe
+} MonitorProgress;
+
+// One discovery worker's buffers, carved from sweep_arena before it starts.
+typedef struct {
+    DiscoveryQueue* queue;
+    ProbeTarget* targets;
+    uint32_t* addrs;
+    PortList* ports;
+    bool* answered;
+} DiscoveryWorker;
+
+// --- Function Prototypes ---
+void monitor_probe_hosts(const uint32_t* addrs, int count);
+void run_discovery(int concurrency);
+static void add_internet_check(void);
+static void finish_first_sweep(uint64_t discovery_start_us);
+static void* rediscovery_thread_main(void* arg);
+static int restore_inventory(void);
+uint64_t next_probe_delay_ms(HostStatus status, int consecutive_failures);
+uint32_t next_random();
+
+
+// --- Lifecycle ---
+// Drops probe methods this process lacks the privilege for, keeping TCP as
+// the last resort so monitoring always has a way to reach hosts. SYN falls
+// back to TCP connects in place.
+static void select_probe_methods(void) {
+    bool has_tcp = false;
+    for (int i = 0; i < probe_method_count; i++) {
+        if (probe_methods[i] == PROBE_METHOD_TCP) has_tcp = true;
+    }
+    int kept = 0;
+    for (int i = 0; i < probe_method_count; i++) {
+        if (probe_method_available(probe_methods[i])) {
+            probe_methods[kept++] = probe_methods[i];
+        } else if (probe_methods[i] == PROBE_METHOD_SYN) {
+            printf("Probe method syn needs raw sockets (root or CAP_NET_RAW on Linux); using tcp connects instead.\n");
+            if (!has_tcp) probe_methods[kept++] = PROBE_METHOD_TCP;
+            has_tcp = true;
+        } else {
+            printf("Probe method %s is not available here (missing privilege or unsupported); skipping it.\n", probe_method_name(probe_methods[i]));
+        }
+    }
+    if (kept == 0) probe_methods[kept++] = PROBE_METHOD_TCP;
+    probe_method_count = kept;
+
+    char names[32] = "";
+    for (int i = 0; i < probe_method_count; i++) {
+        if (i > 0) strcat(names, ",");
+        strcat(names, probe_method_name(probe_methods[i]));
+    }
+    printf("Probe methods: %s\n", names);
+}
+
+bool monitor_start(void) {
+    select_probe_methods();
+    struct in_addr internet_addr;
+    inet_pton(AF_INET, INTERNET_CHECK_IP, &internet_addr);
+    internet_check_addr = ntohl(internet_addr.s_addr);
+    if (!resolver_init(RESOLVER_THREADS, on_hostname_resolved, NULL)) {
+        printf("Failed to start the DNS resolver. Hostnames will not be shown.\n");
+    }
+
+    events_start(); // On failure, changes are delivered inline instead
+    if (!collector_start()) {
+        resolver_shutdown();
+        events_stop();
+        return false;
+    }
+    if (pthread_create(&network_thread, NULL, network_thread_main, NULL) != 0) {
+        printf("Failed to create network thread!\n");
+        collector_stop();
+        resolver_shutdown();
+        events_stop();
+        return false;
+    }
+    agent_start(); // Keeps retrying in the background if the collector is not up yet
+    return true;
+}
+
+void monitor_stop(void) {
+    app_is_running = false; // Signal threads to exit
+    scheduler_wake();
+    pthread_mutex_lock(&rediscovery_mutex);
+    pthread_cond_broadcast(&rediscovery_cond);
+    pthread_mutex_unlock(&rediscovery_mutex);
+    // FIX: Wait for the network thread to finish cleanly instead of cancelling it
+    printf("Shutting down network thread...\n");
+    pthread_join(network_thread, NULL);
+    agent_stop();
+    collector_stop();
+    resolver_shutdown();
+    if (inventory_path && discovered_hosts_count > 0) save_inventory();
+    events_stop(); // After every producer is gone, so the last changes are delivered
+    printf("Network thread joined. Exiting.\n");
+}
+
+void monitor_cleanup(void) {
+    free(discovered_hosts);
+    discovered_hosts = NULL;
+    for (uint32_t chunk = 0; chunk * HOST_DETAIL_CHUNK < detail_slots; chunk++) free(host_detail_chunks[chunk]);
+    free(host_detail_chunks);
+    free(free_details);
+    host_detail_chunks = NULL;
+    free_details = NULL;
+    detail_slots = free_detail_count = 0;
+    discovered_hosts_count = discovered_hosts_capacity = 0;
+    arena_free(&batch_arena);
+    arena_free(&sweep_arena);
+    host_index_free(&host_index);
+    string_arena_free(&host_names);
+    scheduler_free();
+    target_spec_free(&scan_targets);
+    collector_cleanup();
+    host_addr_cleanup();
+}
+
+// Queues status changes for the dispatch thread, which feeds the notify
+// sinks, the status change hook and alerts. Never blocks on a sink.
+static void report_status_changes(const StatusChange* changes, int count) {
+    events_publish(changes, count);
+}
+
+static uint64_t lock_acquired_us = 0; // Traced builds; only the lock holder touches it
+
+void host_list_lock(void) {
+    __atomic_add_fetch(&monitor_stats.lock_acquisitions, 1, __ATOMIC_RELAXED);
+    uint64_t request_us = trace_now();
+    lock_acquired_us = request_us; // An uncontended lock waited 0 us
+    if (pthread_mutex_trylock(&host_list_mutex) != 0) {
+        uint64_t start_us = monotonic_us(); // Uncontended locks skip the clock reads
+        pthread_mutex_lock(&host_list_mutex);
+        __atomic_add_fetch(&monitor_stats.lock_contended, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&monitor_stats.lock_wait_us, monotonic_us() - start_us, __ATOMIC_RELAXED);
+        lock_acquired_us = trace_now();
+    }
+    trace_record(TRACE_LOCK_WAIT, request_us, lock_acquired_us - request_us);
+}
+
+void host_list_unlock(void) {
+    uint64_t acquired_us = lock_acquired_us;
+    uint64_t released_us = trace_now();
+    pthread_mutex_unlock(&host_list_mutex);
+    trace_record(TRACE_LOCK_HOLD, acquired_us, released_us - acquired_us);
+}
+
+static void report_table_changed(void) {
+    if (host_table_hook) host_table_hook();
+}
+
+static void fill_status_change(StatusChange* change, const MonitoredHost* host, HostStatus old_status) {
+    change->addr = host->addr;
+    format_host_addr(host->addr, change->ip, sizeof(change->ip));
+    strncpy(change->hostname, host->hostname, sizeof(change->hostname) - 1);
+    change->hostname[sizeof(change->hostname) - 1] = '\0';
+    change->old_status = old_status;
+    change->new_status = host->status;
+    change->consecutive_failures = host->consecutive_failures;
+    rtt_compute_stats(&host_detail(host->detail)->rtt, &change->rtt);
+}
+
+// Returns the interned copy of name, falling back to a shared placeholder if
+// the arena is out of memory. Caller holds host_list_mutex.
+static const char* intern_hostname(const char* name) {
+    const char* interned = string_arena_intern(&host_names, name);
+    return interned ? interned : "N/A";
+}
+
+// --- Networking Thread Logic ---
+uint64_t host_order_key(const MonitoredHost* host) {
+    uint64_t ipv6 = host_id_is_ipv6(host->addr) ? 1 : 0;
+    return ((uint64_t)(host->flags & HOST_FLAG_PINNED) << 33) | (ipv6 << 32) | host->addr;
+}
+
+// Returns the row a host with this key belongs at. Discovery mostly finds
+// hosts in address order, so this is usually the end of the table.
+// Caller holds host_list_mutex.
+static int host_insertion_point(uint64_t key) {
+    int low = 0, high = discovered_hosts_count;
+    if (high > 0 && host_order_key(&discovered_hosts[high - 1]) < key) return high;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (host_order_key(&discovered_hosts[mid]) < key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Rows shift on every insert and removal, so the index holds each host's
+// detail slot, which never moves, and the row is found by binary search of
+// the sorted table. Caller holds host_list_mutex.
+int host_row(uint32_t addr) {
+    int slot = host_index_get(&host_index, addr);
+    if (slot < 0) return -1;
+    MonitoredHost key;
+    key.addr = addr;
+    for (int pinned = 0; pinned <= 1; pinned++) {
+        key.flags = pinned ? HOST_FLAG_PINNED : 0;
+        int row = host_insertion_point(host_order_key(&key));
+        if (row < discovered_hosts_count && discovered_hosts[row].detail == (uint32_t)slot) return row;
+    }
+    return -1;
+}
+
+// Moves port to the front of the list so it is tried first next time.
+void port_list_promote(PortList* list, uint16_t port) {
+    for (int i = 0; i < PORT_LIST_COUNT(list); i++) {
+        if (list->ports[i] != port) continue;
+        memmove(&list->ports[1], &list->ports[0], i * sizeof(uint16_t));
+        list->ports[0] = port;
+        return;
+    }
+}
+
+// Returns a free detail slot, adding a chunk when every slot is taken, or
+// UINT32_MAX when out of memory. Caller holds host_list_mutex.
+static uint32_t take_detail_slot(void) {
+    if (free_detail_count > 0) return free_details[--free_detail_count];
+    if (detail_slots % HOST_DETAIL_CHUNK == 0) {
+        uint32_t chunks = detail_slots / HOST_DETAIL_CHUNK + 1;
+        HostDetail** table = realloc(host_detail_chunks, chunks * sizeof(HostDetail*));
+        if (!table) return UINT32_MAX;
+        host_detail_chunks = table;
+        uint32_t* free_list = realloc(free_details, chunks * HOST_DETAIL_CHUNK * sizeof(uint32_t));
+        if (!free_list) return UINT32_MAX;
+        free_details = free_list;
+        HostDetail* chunk = malloc(HOST_DETAIL_CHUNK * sizeof(HostDetail));
+        if (!chunk) return UINT32_MAX;
+        host_detail_chunks[chunks - 1] = chunk;
+    }
+    return detail_slots++;
+}
+
+// Adds addr at its place in the table unless it is already known. hostname is
+// shown until reverse DNS answers; resolve is false for fixed names such as
+// the internet check.
+static void insert_host(uint32_t addr, uint16_t open_port, const char* hostname, bool resolve, HostStatus status, uint8_t flags) {
+    host_list_lock();
+    if (host_index_get(&host_index, addr) >= 0) {
+        host_list_unlock();
+        return;
+    }
+
+    MonitoredHost* hosts = discovered_hosts;
+    if (discovered_hosts_count >= discovered_hosts_capacity) {
+        // Rows are small; the details they point at stay put in their chunks
+        int capacity = (discovered_hosts_capacity == 0) ? 64 : discovered_hosts_capacity * 2;
+        hosts = realloc(discovered_hosts, capacity * sizeof(MonitoredHost));
+        if (hosts) {
+            discovered_hosts = hosts;
+            discovered_hosts_capacity = capacity;
+        }
+    }
+    uint32_t slot = hosts ? take_detail_slot() : UINT32_MAX;
+    if (slot != UINT32_MAX && !host_index_put(&host_index, addr, (int)slot)) {
+        free_details[free_detail_count++] = slot;
+        slot = UINT32_MAX;
+    }
+    if (slot == UINT32_MAX) {
+        host_list_unlock();
+        printf("Out of memory; not monitoring another host.\n");
+        return;
+    }
+
+    MonitoredHost entry;
+    entry.hostname = intern_hostname(hostname);
+    entry.addr = addr;
+    entry.flags = flags;
+    entry.status = status;
+    // A host last seen DOWN stays DOWN until it answers again
+    entry.consecutive_failures = (status == STATUS_DOWN) ? fail_threshold : 0;
+    entry.rtt_avg_us = RTT_LOST;
+    entry.flash_timer = 1.0f; // Flash on discovery
+    entry.detail = slot;
+
+    // Sorted insertion keeps the table in display order without a re-sort
+    int index = host_insertion_point(host_order_key(&entry));
+    memmove(&discovered_hosts[index + 1], &discovered_hosts[index], (discovered_hosts_count - index) * sizeof(MonitoredHost));
+    discovered_hosts[index] = entry;
+    MonitoredHost* host = &discovered_hosts[index];
+
+    HostDetail* detail = host_detail(slot);
+    detail->down_since_ms = (status == STATUS_DOWN) ? monotonic_ms() : 0;
+    detail->ports = *ports_for_host(addr);
+    rtt_clear(&detail->rtt);
+    rtt_timeline_clear(&detail->timeline);
+    detail->probes_total = 0;
+    detail->failures_total = 0;
+    if (open_port) port_list_promote(&detail->ports, open_port);
+
+    discovered_hosts_count++;
+    hosts_inserted++;
+
+    StatusChange change;
+    fill_status_change(&change, host, STATUS_SCANNING);
+    host_table_version++;
+    metrics_publish_if_due(discovered_hosts, discovered_hosts_count);
+
+    // First probe lands at a random point in the interval so load is spread evenly
+    uint64_t first_probe = monotonic_ms() + next_random() % (uint32_t)monitor_interval_ms;
+    
+    host_list_unlock();
+
+    // Reverse DNS runs on the resolver pool, never under host_list_mutex
+    if (resolve) resolver_request(addr);
+    if (!(flags & HOST_FLAG_REMOTE)) scheduler_add(addr, first_probe); // Agents probe their own hosts
+    report_status_changes(&change, 1);
+    report_table_changed();
+}
+
+// open_port is the port discovery found open, or 0 when none is known.
+void add_host_to_list(uint32_t addr, uint16_t open_port, const char* hostname_override) {
+    insert_host(addr, open_port, hostname_override ? hostname_override : HOSTNAME_RESOLVING, !hostname_override, STATUS_UP, 0);
+}
+
+// Drops the host at row index; its detail slot goes back on the free list.
+// Caller holds host_list_mutex.
+static void remove_host(int index) {
+    uint32_t addr = discovered_hosts[index].addr;
+    free_details[free_detail_count++] = discovered_hosts[index].detail;
+
+    host_index_remove(&host_index, addr);
+    memmove(&discovered_hosts[index], &discovered_hosts[index + 1], (discovered_hosts_count - index - 1) * sizeof(MonitoredHost));
+    discovered_hosts_count--;
+    host_table_version++;
+}
+
+// Drops every host marked HOST_FLAG_EXPIRED in one pass, so a batch that
+// ages out many hosts moves the table once. Caller holds host_list_mutex.
+static void remove_expired_hosts(void) {
+    int kept = 0;
+    for (int i = 0; i < discovered_hosts_count; i++) {
+        MonitoredHost* host = &discovered_hosts[i];
+        if (host->flags & HOST_FLAG_EXPIRED) {
+            free_details[free_detail_count++] = host->detail;
+            host_index_remove(&host_index, host->addr);
+            continue;
+        }
+        if (kept != i) discovered_hosts[kept] = *host;
+        kept++;
+    }
+    discovered_hosts_count = kept;
+}
+
+void on_hostname_resolved(uint32_t addr, const char* hostname, void* ctx) {
+    (void)ctx;
+    host_list_lock();
+    int i = host_row(addr);
+    // A failed lookup keeps a name restored from the inventory
+    if (i >= 0 && (hostname || strcmp(discovered_hosts[i].hostname, HOSTNAME_RESOLVING) == 0)) {
+        discovered_hosts[i].hostname = intern_hostname(hostname ? hostname : "N/A");
+        host_table_version++;
+    }
+    host_list_unlock();
+    if (i >= 0) report_table_changed();
+}
+
+bool on_discovery_result(const ProbeResult* result, void* ctx) {
+    bool* answered = (bool*)ctx;
+    if (result->outcome != PROBE_OPEN) return false;
+    answered[result->target->group] = true;
+    add_host_to_list(result->target->addr, result->target->port, NULL);
+    return true; // One answer is enough, skip the rest for this host
+}
+
+// Writes the probes for every host not yet answered: one per host for ICMP
+// and ARP, or one per port from first_port on for TCP and SYN. Returns the count.
+int build_stage_targets(ProbeMethod method, const uint32_t* addrs, const PortList* ports, int count, const bool* answered, int first_port, ProbeTarget* targets) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (answered[i]) continue;
+        if (!probe_method_uses_ports(method)) {
+            targets[n].addr = addrs[i];
+            targets[n].port = 0;
+            targets[n].group = i;
+            n++;
+            continue;
+        }
+        for (int p = first_port; p < PORT_LIST_COUNT(&ports[i]); p++) {
+            targets[n].addr = addrs[i];
+            targets[n].port = ports[i].ports[p];
+            targets[n].group = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+// Runs the probe methods in order over hosts, each only seeing the hosts the
+// previous ones got no answer from. targets holds MAX_HOST_PORTS per host.
+static void probe_discovery_hosts(const uint32_t* addrs, const PortList* ports, bool* answered, int hosts, ProbeTarget* targets, const ProbeOptions* options) {
+    for (int m = 0; m < probe_method_count && app_is_running; m++) {
+        int n = build_stage_targets(probe_methods[m], addrs, ports, hosts, answered, 0, targets);
+        if (n == 0) break;
+        probe_method_batch(probe_methods[m], targets, n, options);
+    }
+}
+
+// Claims chunks of hosts from the shared queue until it runs dry. Addresses
+// are generated per chunk, so even a /16 needs only one chunk of targets.
+void* discovery_worker(void* arg) {
+    DiscoveryWorker* worker = (DiscoveryWorker*)arg;
+    DiscoveryQueue* queue = worker->queue;
+    ProbeOptions options = {connect_timeout_ms, queue->window, on_discovery_result, worker->answered, &app_is_running};
+
+    while (app_is_running) {
+        uint64_t start = __atomic_fetch_add(&queue->next_index, (uint64_t)queue->chunk_hosts, __ATOMIC_RELAXED);
+        if (start >= scan_targets.total) break;
+
+        // Known hosts are already monitored; a sweep only looks for new ones
+        int hosts = 0;
+        host_list_lock();
+        for (uint64_t k = start; k < start + (uint64_t)queue->chunk_hosts && k < scan_targets.total; k++) {
+            uint32_t addr = target_spec_addr_at(&scan_targets, k);
+            if (host_index_get(&host_index, addr) >= 0) continue;
+            worker->addrs[hosts] = addr;
+            worker->ports[hosts] = *ports_for_host(addr);
+            worker->answered[hosts] = false;
+            hosts++;
+        }
+        host_list_unlock();
+
+        probe_discovery_hosts(worker->addrs, worker->ports, worker->answered, hosts, worker->targets, &options);
+    }
+    return NULL;
+}
+
+static void* discovery_thread_main(void* arg) {
+    trace_name_thread("discovery");
+    return discovery_worker(arg);
+}
+
+// Addresses reported by the neighbor table and the all-nodes ping, deduped.
+typedef struct {
+    HostIndex seen;
+    uint32_t* addrs;
+    int count;
+    int capacity;
+} NeighborSeed;
+
+static void collect_neighbor(uint32_t id, void* ctx) {
+    NeighborSeed* seed = (NeighborSeed*)ctx;
+    // IPv4 neighbors outside the targets stay out; IPv6 has no targets to check
+    if (!host_id_is_ipv6(id) && !target_spec_contains(&scan_targets, id)) return;
+    if (host_index_get(&seed->seen, id) >= 0) return;
+    if (seed->count == seed->capacity) {
+        int capacity = seed->capacity ? seed->capacity * 2 : 64;
+        uint32_t* addrs = realloc(seed->addrs, capacity * sizeof(uint32_t));
+        if (!addrs) return;
+        seed->addrs = addrs;
+        seed->capacity = capacity;
+    }
+    if (!host_index_put(&seed->seen, id, seed->count)) return;
+    seed->addrs[seed->count++] = id;
+}
+
+// Probes the hosts the OS already knows are on the link before the sweep, so
+// they are monitored within one probe timeout instead of wherever the sweep
+// reaches them. With --ipv6 this is also how IPv6 hosts are found at all.
+static void seed_from_neighbors(int concurrency) {
+    NeighborSeed seed;
+    memset(&seed, 0, sizeof(seed));
+    if (ipv6_discovery && neighbor_ping_all_nodes(NEIGHBOR_PING_TIMEOUT_MS, collect_neighbor, &seed) < 0) {
+        printf("IPv6 all-nodes ping unavailable (no ICMPv6 socket); using the neighbor table only.\n");
+    }
+    neighbor_table_read(ipv6_discovery ? AF_UNSPEC : AF_INET, collect_neighbor, &seed);
+    host_index_free(&seed.seen);
+
+    // Known hosts are already monitored
+    int hosts = 0;
+    host_list_lock();
+    for (int i = 0; i < seed.count; i++) {
+        if (host_index_get(&host_index, seed.addrs[i]) < 0) seed.addrs[hosts++] = seed.addrs[i];
+    }
+    host_list_unlock();
+
+    ProbeTarget* targets = hosts ? arena_alloc(&sweep_arena, hosts * MAX_HOST_PORTS * sizeof(ProbeTarget)) : NULL;
+    PortList* ports = hosts ? arena_alloc(&sweep_arena, hosts * sizeof(PortList)) : NULL;
+    bool* answered = hosts ? arena_calloc(&sweep_arena, hosts, sizeof(bool)) : NULL;
+    if (targets && ports && answered) {
+        for (int i = 0; i < hosts; i++) ports[i] = *ports_for_host(seed.addrs[i]);
+        ProbeOptions options = {connect_timeout_ms, concurrency, on_discovery_result, answered, &app_is_running};
+        probe_discovery_hosts(seed.addrs, ports, answered, hosts, targets, &options);
+
+        int found = 0;
+        for (int i = 0; i < hosts; i++) found += answered[i] ? 1 : 0;
+        printf("Neighbor table: %d of %d new neighbors answered.\n", found, hosts);
+    }
+    free(seed.addrs);
+}
+
+// Carves one worker's buffers out of sweep_arena. False when out of memory.
+static bool init_discovery_worker(DiscoveryWorker* worker, DiscoveryQueue* queue) {
+    worker->queue = queue;
+    worker->targets = arena_alloc(&sweep_arena, queue->chunk_hosts * MAX_HOST_PORTS * sizeof(ProbeTarget));
+    worker->addrs = arena_alloc(&sweep_arena, queue->chunk_hosts * sizeof(uint32_t));
+    worker->ports = arena_alloc(&sweep_arena, queue->chunk_hosts * sizeof(PortList));
+    worker->answered = arena_alloc(&sweep_arena, queue->chunk_hosts * sizeof(bool));
+    return worker->targets && worker->addrs && worker->ports && worker->answered;
+}
+
+// Runs discovery over scan_targets with discovery_threads workers sharing
+// concurrency in-flight connects, after probing the known neighbors.
+void run_discovery(int concurrency) {
+    uint64_t sweep_start_us = trace_now();
+    arena_reset(&sweep_arena); // The previous sweep is done with its scratch
+    seed_from_neighbors(concurrency);
+    if (!app_is_running) return;
+
+    DiscoveryQueue queue;
+    queue.next_index = 0;
+    queue.window = concurrency / discovery_threads;
+    if (queue.window < 1) queue.window = 1;
+    // Claim twice the window per grab so the engine rarely runs dry between chunks
+    queue.chunk_hosts = (queue.window * 2 + PORT_LIST_COUNT(&default_ports) - 1) / PORT_LIST_COUNT(&default_ports);
+
+    pthread_t* threads = arena_alloc(&sweep_arena, discovery_threads * sizeof(pthread_t));
+    DiscoveryWorker* workers = arena_alloc(&sweep_arena, discovery_threads * sizeof(DiscoveryWorker));
+    if (!threads || !workers || !init_discovery_worker(&workers[0], &queue)) return;
+
+    int started = 0;
+    for (int i = 0; i < discovery_threads; i++) {
+        // Every buffer is carved out before its thread starts, so the arena is never shared
+        if (i > 0 && !init_discovery_worker(&workers[i], &queue)) break;
+        if (pthread_create(&threads[started], NULL, discovery_thread_main, &workers[i]) != 0) {
+            perror("Failed to create discovery thread");
+            break;
+        }
+        started++;
+    }
+    // Without any worker, discover on this thread instead
+    if (started == 0) discovery_worker(&workers[0]);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    trace_record(TRACE_SWEEP, sweep_start_us, trace_now() - sweep_start_us);
+}
+
+bool on_monitor_result(const ProbeResult* result, void* ctx) {
+    MonitorProgress* progress = (MonitorProgress*)ctx;
+    if (result->outcome != PROBE_OPEN) return false;
+    progress->answered[result->target->group] = true;
+    progress->open_port[result->target->group] = result->target->port; // 0 for ICMP and ARP
+    progress->rtt_us[result->target->group] = result->rtt_us;
+    return true;
+}
+
+// Small xorshift generator for probe jitter. Callers hold host_list_mutex.
+uint32_t next_random() {
+    static uint32_t state = 0;
+    if (state == 0) state = (uint32_t)monotonic_us() | 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Picks how long until a host is probed again: the base interval when UP,
+// faster while UNSTABLE, and exponentially slower the longer it stays DOWN.
+uint64_t next_probe_delay_ms(HostStatus status, int consecutive_failures) {
+    uint64_t delay = (uint64_t)monitor_interval_ms;
+    if (status == STATUS_UNSTABLE) {
+        delay /= UNSTABLE_SPEEDUP;
+    } else if (status == STATUS_DOWN) {
+        int doublings = consecutive_failures - fail_threshold + 1;
+        while (doublings-- > 0 && delay < MAX_DOWN_BACKOFF_S * 1000ULL) delay *= 2;
+        if (delay > MAX_DOWN_BACKOFF_S * 1000ULL) delay = MAX_DOWN_BACKOFF_S * 1000ULL;
+    }
+
+    uint64_t spread = delay * (uint64_t)monitor_jitter_percent / 100;
+    if (spread > 0) delay = delay - spread + next_random() % (2 * spread + 1);
+    return delay > 0 ? delay : 1;
+}
+
+// Probes a batch of due hosts and schedules each one again. The host list is
+// only locked to publish the results, never while connects are in flight,
+// so the render loop keeps its frame budget.
+void monitor_probe_hosts(const uint32_t* addrs, int count) {
+    if (count <= 0) return;
+    arena_reset(&batch_arena); // The previous batch is done with its scratch
+    ProbeTarget* targets = arena_alloc(&batch_arena, count * MAX_HOST_PORTS * sizeof(ProbeTarget));
+    PortList* ports = arena_alloc(&batch_arena, count * sizeof(PortList));
+    uint16_t* open_port = arena_calloc(&batch_arena, count, sizeof(uint16_t));
+    bool* answered = arena_calloc(&batch_arena, count, sizeof(bool));
+    uint32_t* rtt_us = arena_calloc(&batch_arena, count, sizeof(uint32_t));
+    StatusChange* changes = arena_alloc(&batch_arena, count * sizeof(StatusChange));
+    if (!targets || !ports || !open_port || !answered || !rtt_us || !changes) {
+        // Try again later rather than dropping the hosts from the schedule
+        for (int i = 0; i < count; i++) scheduler_add(addrs[i], monotonic_ms() + (uint64_t)monitor_interval_ms);
+        return;
+    }
+
+    host_list_lock();
+    for (int i = 0; i < count; i++) {
+        int index = host_row(addrs[i]);
+        ports[i] = (index >= 0) ? host_detail(discovered_hosts[index].detail)->ports : *ports_for_host(addrs[i]);
+    }
+    host_list_unlock();
+
+    uint64_t batch_start_us = monotonic_us();
+    MonitorProgress progress = {answered, open_port, rtt_us};
+    ProbeOptions options = {connect_timeout_ms, monitor_window, on_monitor_result, &progress, &app_is_running};
+    for (int m = 0; m < probe_method_count && app_is_running; m++) {
+        if (probe_methods[m] != PROBE_METHOD_TCP) {
+            // One packet per unanswered host (per port for SYN), the whole batch in one burst
+            int n = build_stage_targets(probe_methods[m], addrs, ports, count, answered, 0, targets);
+            probe_method_batch(probe_methods[m], targets, n, &options);
+            continue;
+        }
+
+        // Stage 1: only each host's preferred port, which answers for almost every live host
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            if (answered[i] || PORT_LIST_COUNT(&ports[i]) == 0) continue;
+            targets[n].addr = addrs[i];
+            targets[n].port = ports[i].ports[0];
+            targets[n].group = i;
+            n++;
+        }
+        probe_batch(targets, n, &options);
+
+        // Stage 2: the remaining ports, concurrently, for hosts that did not answer
+        n = build_stage_targets(PROBE_METHOD_TCP, addrs, ports, count, answered, 1, targets);
+        probe_batch(targets, n, &options);
+    }
+
+    if (!app_is_running) return; // Partial results from an interrupted batch would look like failures
+
+    int change_count = 0, expired = 0;
+    uint64_t now = monotonic_ms();
+    host_list_lock();
+    for (int i = 0; i < count; i++) {
+        int index = host_row(addrs[i]);
+        if (index < 0) continue; // Host was removed while probing
+        MonitoredHost* host = &discovered_hosts[index];
+        HostDetail* detail = host_detail(host->detail);
+
+        HostStatus old_status = host->status;
+        rtt_timeline_add(&detail->timeline, answered[i], rtt_us[i]);
+        detail->probes_total++;
+        if (!answered[i]) detail->failures_total++;
+        if (answered[i]) {
+            rtt_record(&detail->rtt, rtt_us[i]);
+            host->rtt_avg_us = rtt_average(&detail->rtt);
+            // A host that answers but has slowed down sharply is flagged before it drops out
+            host->status = rtt_is_degraded(&detail->rtt, latency_factor) ? STATUS_UNSTABLE : STATUS_UP;
+            host->consecutive_failures = 0;
+            if (open_port[i]) port_list_promote(&detail->ports, open_port[i]);
+        } else {
+            if (host->consecutive_failures < HOST_FAILURES_MAX) host->consecutive_failures++;
+            if (host->consecutive_failures >= fail_threshold) {
+                if (host->status != STATUS_DOWN) detail->down_since_ms = now;
+                host->status = STATUS_DOWN;
+            } else {
+                host->status = STATUS_UNSTABLE;
+            }
+        }
+        if (old_status != host->status) {
+            host->flash_timer = 1.0f;
+            fill_status_change(&changes[change_count++], host, old_status);
+        }
+        if (age_out_s > 0 && host->status == STATUS_DOWN && !(host->flags & HOST_FLAG_PINNED)
+            && now - detail->down_since_ms >= (uint64_t)age_out_s * 1000) {
+            char ip[HOST_ADDR_STRLEN];
+            format_host_addr(host->addr, ip, sizeof(ip));
+            printf("%s (%s) has been DOWN for %d s; no longer monitoring it\n", ip, host->hostname, age_out_s);
+            host->flags |= HOST_FLAG_EXPIRED; // Not rescheduled; a later sweep adds it back if it returns
+            expired++;
+            continue;
+        }
+        scheduler_add(addrs[i], now + next_probe_delay_ms(host->status, host->consecutive_failures));
+    }
+    if (expired > 0) remove_expired_hosts();
+    host_table_version++;
+    metrics_publish_if_due(discovered_hosts, discovered_hosts_count);
+    host_list_unlock();
+    __atomic_add_fetch(&monitor_stats.batches, 1, __ATOMIC_RELAXED);
+    uint64_t batch_us = monotonic_us() - batch_start_us;
+    __atomic_store_n(&monitor_stats.last_batch_us, batch_us, __ATOMIC_RELAXED);
+    trace_record(TRACE_BATCH, batch_start_us, batch_us);
+
+    // Report outside the critical section; sinks may block on I/O
+    report_status_changes(changes, change_count);
+    report_table_changed(); // RTTs moved even if no status did
+}
+
+void* network_thread_main(void* arg) {
+    (void)arg;
+    trace_name_thread("network");
+
+    // --- Phase 1: Detect Subnet and Discover Hosts ---
+    if (scan_targets.count == 0) {
+        uint32_t network;
+        int prefix_len;
+        if (get_local_ip_and_subnet(&network, &prefix_len) && target_spec_add_cidr(&scan_targets, network, prefix_len)) {
+            target_spec_describe(&scan_targets, active_subnet, sizeof(active_subnet));
+            printf("Detected local subnet. Scanning %s\n", active_subnet);
+        } else {
+            printf("Could not detect local subnet. Falling back to %s\n", DEFAULT_SUBNET);
+            target_spec_parse(DEFAULT_SUBNET, &scan_targets);
+            target_spec_describe(&scan_targets, active_subnet, sizeof(active_subnet));
+        }
+    }
+
+    monitor_window = probe_concurrency;
+    int restored = inventory_path ? restore_inventory() : 0;
+    if (restored > 0) {
+        // Warm start: monitor the saved hosts now and sweep for new ones alongside
+        add_internet_check();
+        printf("Restored %d hosts from %s; rediscovering in the background\n", restored, inventory_path);
+    } else {
+        uint64_t discovery_start_us = monotonic_us();
+        run_discovery(probe_concurrency);
+        if (app_is_running) finish_first_sweep(discovery_start_us);
+    }
+    if (app_is_running && (!discovery_complete || rediscover_interval_s > 0)) {
+        rediscovery_started = pthread_create(&rediscovery_thread, NULL, rediscovery_thread_main, NULL) == 0;
+        if (!rediscovery_started) perror("Failed to create rediscovery thread");
+    }
+
+    // --- Phase 2: Monitoring ---
+    // Hosts were scheduled as they were discovered; sleep until the next one is due
+    uint32_t due[MONITOR_BATCH_MAX];
+    while (app_is_running) { // FIX: Check the global running flag
+        int count = scheduler_wait_due(due, MONITOR_BATCH_MAX, MONITOR_COALESCE_MS, &app_is_running);
+        if (count > 0) monitor_probe_hosts(due, count);
+    }
+    if (rediscovery_started) {
+        pthread_join(rediscovery_thread, NULL);
+        rediscovery_started = false;
+    }
+    return NULL;
+}
+
+// --- Warm Start ---
+// Pinned, so it stays below every discovered host however late they arrive.
+static void add_internet_check(void) {
+    insert_host(internet_check_addr, 0, "INTERNET", false, STATUS_UP, HOST_FLAG_PINNED);
+}
+
+// Marks discovery complete once the first sweep is through, then saves the
+// inventory. An interrupted sweep is saved by monitor_stop() instead.
+static void finish_first_sweep(uint64_t discovery_start_us) {
+    __atomic_store_n(&monitor_stats.discovery_us, monotonic_us() - discovery_start_us, __ATOMIC_RELAXED);
+    add_internet_check();
+    discovery_complete = true;
+    report_table_changed();
+    if (inventory_path) save_inventory();
+}
+
+// --- Background Rediscovery ---
+// Sleeps up to delay_ms, returning early when monitor_stop() signals.
+static void wait_for_rediscovery(uint64_t delay_ms) {
+    struct timespec deadline;
+    wall_clock_deadline(delay_ms, &deadline);
+    pthread_mutex_lock(&rediscovery_mutex);
+    // Loop: a spurious wakeup must not start a sweep early
+    while (app_is_running) {
+        if (pthread_cond_timedwait(&rediscovery_cond, &rediscovery_mutex, &deadline) == ETIMEDOUT) break;
+    }
+    pthread_mutex_unlock(&rediscovery_mutex);
+}
+
+// Sweeps scan_targets with 1/share of probe_concurrency while monitoring
+// keeps the rest. Returns how many new hosts were added.
+static int background_sweep(int share) {
+    int window = probe_concurrency / share;
+    if (window < 1) window = 1;
+    monitor_window = (probe_concurrency > window) ? probe_concurrency - window : 1;
+
+    host_list_lock();
+    unsigned int inserted_before = hosts_inserted;
+    host_list_unlock();
+    rediscovery_active = true;
+    report_table_changed();
+
+    run_discovery(window);
+
+    rediscovery_active = false;
+    monitor_window = probe_concurrency;
+    host_list_lock();
+    int found = (int)(hosts_inserted - inserted_before);
+    host_list_unlock();
+    report_table_changed();
+    return found;
+}
+
+// Finishes a warm start's first sweep, then keeps sweeping every
+// rediscover_interval_s for hosts that joined since.
+static void* rediscovery_thread_main(void* arg) {
+    (void)arg;
+    trace_name_thread("rediscovery");
+    if (!discovery_complete) {
+        uint64_t discovery_start_us = monotonic_us();
+        background_sweep(2); // Restored hosts are few enough to share half the budget
+        if (!app_is_running) return NULL;
+        finish_first_sweep(discovery_start_us);
+    }
+
+    while (app_is_running && rediscover_interval_s > 0) {
+        wait_for_rediscovery((uint64_t)rediscover_interval_s * 1000);
+        if (!app_is_running) break;
+        int found = background_sweep(REDISCOVERY_SHARE);
+        if (!app_is_running) break;
+        if (found > 0) {
+            printf("Rediscovery found %d new host%s on %s\n", found, found == 1 ? "" : "s", active_subnet);
+            if (inventory_path) save_inventory();
+        }
+    }
+    return NULL;
+}
+
+static void on_inventory_record(const InventoryRecord* record, void* ctx) {
+    int* restored = (int*)ctx;
+    if (!target_spec_contains(&scan_targets, record->addr)) return; // Outside this run's targets
+    const char* hostname = record->hostname[0] ? record->hostname : HOSTNAME_RESOLVING;
+    insert_host(record->addr, record->preferred_port, hostname, true, record->status, 0);
+    (*restored)++;
+}
+
+// Loads inventory_path into the table. Returns the number of hosts restored.
+static int restore_inventory(void) {
+    int restored = 0;
+    if (inventory_load(inventory_path, on_inventory_record, &restored) <= 0) return 0;
+    return restored;
+}
+
+// Writes every host except the internet check to inventory_path. IPv6 ids
+// only last for the run, so those hosts are rediscovered instead; agents
+// resend their own hosts when they reconnect. The table
+// is copied under the lock and written after it is released.
+bool save_inventory(void) {
+    host_list_lock();
+    int count = 0;
+    InventoryRecord* records = malloc((discovered_hosts_count ? discovered_hosts_count : 1) * sizeof(InventoryRecord));
+    for (int i = 0; records && i < discovered_hosts_count; i++) {
+        const MonitoredHost* host = &discovered_hosts[i];
+        if ((host->flags & (HOST_FLAG_PINNED | HOST_FLAG_REMOTE)) || host_id_is_ipv6(host->addr)) continue;
+        const PortList* ports = &host_detail(host->detail)->ports;
+        InventoryRecord* record = &records[count++];
+        record->addr = host->addr;
+        record->preferred_port = PORT_LIST_COUNT(ports) > 0 ? ports->ports[0] : 0;
+        record->status = host->status;
+        bool placeholder = strcmp(host->hostname, HOSTNAME_RESOLVING) == 0;
+        strncpy(record->hostname, placeholder ? "" : host->hostname, sizeof(record->hostname) - 1);
+        record->hostname[sizeof(record->hostname) - 1] = '\0';
+    }
+    host_list_unlock();
+    if (!records) return false;
+
+    bool saved = inventory_save(inventory_path, records, count);
+    free(records);
+    return saved;
+}
+
+// --- Remote Hosts ---
+void monitor_merge_remote(uint32_t id, const char* hostname, HostStatus status, int consecutive_failures, uint32_t rtt_avg_us) {
+    host_list_lock();
+    int index = host_row(id);
+    host_list_unlock();
+    if (index < 0) insert_host(id, 0, hostname, false, status, HOST_FLAG_REMOTE); // Reports it as new
+
+    host_list_lock();
+    index = host_row(id);
+    if (index < 0) {
+        host_list_unlock(); // Out of memory
+        return;
+    }
+    MonitoredHost* host = &discovered_hosts[index];
+    HostDetail* detail = host_detail(host->detail);
+    HostStatus old_status = host->status;
+    if (strcmp(host->hostname, hostname) != 0) host->hostname = intern_hostname(hostname);
+    host->status = status;
+    host->consecutive_failures = (uint16_t)(consecutive_failures < HOST_FAILURES_MAX ? consecutive_failures : HOST_FAILURES_MAX);
+    host->rtt_avg_us = rtt_avg_us;
+    if (rtt_avg_us != RTT_LOST) rtt_record(&detail->rtt, rtt_avg_us);
+
+    StatusChange change;
+    bool changed = old_status != status;
+    if (changed) {
+        if (status == STATUS_DOWN) detail->down_since_ms = monotonic_ms();
+        host->flash_timer = 1.0f;
+        fill_status_change(&change, host, old_status);
+    }
+    host_table_version++;
+    host_list_unlock();
+    if (changed) report_status_changes(&change, 1);
+    report_table_changed();
+}
+
+void monitor_remove_remote(uint32_t id) {
+    host_list_lock();
+    int index = host_row(id);
+    if (index >= 0) remove_host(index);
+    host_list_unlock();
+    if (index >= 0) report_table_changed();
+}
+
+const char* host_status_name(HostStatus status) {
+    switch (status) {
+        case STATUS_UP: return "UP";
+        case STATUS_UNSTABLE: return "UNSTABLE";
+        case STATUS_DOWN: return "DOWN";
+        default: return "SCANNING";
+    }
+}
+
+// --- Dynamic Subnet Detection ---
+// Reports the network address and real prefix length of the first Ethernet
+// or Wi-Fi interface. Very wide networks are narrowed to the local /24 so an
+// unattended start never sweeps tens of thousands of addresses.
+bool get_local_ip_and_subnet(uint32_t* network, int* prefix_len) {
+    uint32_t local_addr = 0;
+    int prefix = -1;
+#ifdef _WIN32
+    PIP_ADAPTER_ADDRESSES pAddresses = NULL;
+    ULONG outBufLen = 15000;
+    DWORD dwRetVal = 0;
+
+    pAddresses = (IP_ADAPTER_ADDRESSES*)malloc(outBufLen);
+    if (!pAddresses) return false;
+
+    dwRetVal = GetAdaptersAddresses(AF_INET, GAA_FLAG_INCLUDE_PREFIX, NULL, pAddresses, &outBufLen);
+    if (dwRetVal == NO_ERROR) {
+        for (PIP_ADAPTER_ADDRESSES pCurrAddresses = pAddresses; pCurrAddresses != NULL && prefix < 0; pCurrAddresses = pCurrAddresses->Next) {
+            if (pCurrAddresses->IfType == IF_TYPE_ETHERNET_CSMACD || pCurrAddresses->IfType == IF_TYPE_IEEE80211) {
+                PIP_ADAPTER_UNICAST_ADDRESS unicast = pCurrAddresses->FirstUnicastAddress;
+                if (unicast != NULL && unicast->Address.lpSockaddr->sa_family == AF_INET) {
+                    struct sockaddr_in* addr_in = (struct sockaddr_in*)unicast->Address.lpSockaddr;
+                    local_addr = ntohl(addr_in->sin_addr.s_addr);
+                    prefix = unicast->OnLinkPrefixLength;
+                }
+            }
+        }
+    }
+    free(pAddresses);
+#else // Linux/macOS
+    struct ifaddrs *ifaddr, *ifa;
+
+    if (getifaddrs(&ifaddr) == -1) return false;
+
+    for (ifa = ifaddr; ifa != NULL && prefix < 0; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET || ifa->ifa_netmask == NULL) continue;
+        
+        if (strncmp(ifa->ifa_name, "en", 2) == 0 || strncmp(ifa->ifa_name, "eth", 3) == 0 || strncmp(ifa->ifa_name, "wl", 2) == 0) {
+            local_addr = ntohl(((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr);
+            uint32_t mask = ntohl(((struct sockaddr_in*)ifa->ifa_netmask)->sin_addr.s_addr);
+            prefix = 0;
+            while (prefix < 32 && (mask & (0x80000000u >> prefix))) prefix++;
+        }
+    }
+    freeifaddrs(ifaddr);
+#endif
+    if (prefix < 0) return false;
+    if (prefix < MIN_AUTO_PREFIX) {
+        printf("Local network is a /%d; scanning only the local /24.\n", prefix);
+        prefix = 24;
+    }
+    uint32_t mask = (prefix == 0) ? 0 : 0xFFFFFFFFu << (32 - prefix);
+    *network = local_addr & mask;
+    *prefix_len = prefix;
+    return true;
+}
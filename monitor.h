@@ -0,0 +1,187 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "targets.h"
+#include "hostaddr.h"
+#include "hostindex.h"
+#include "rtt.h"
+#include "strarena.h"
+
+// --- Host Monitor Core ---
+// Discovery, scheduling and probing of hosts, with no dependency on SDL.
+// The GUI and the headless daemon both drive the same core and only differ
+// in how they present the host table and its status changes.
+
+// --- Configuration ---
+// Values wrapped in #ifndef can be replaced by a build profile
+// (profile_NAME.h, make PROFILE=NAME).
+#define DEFAULT_SUBNET "192.168.1.0/24" // Fallback subnet
+#define INTERNET_CHECK_IP "8.8.8.8" // Google's public DNS for internet check
+#define MIN_AUTO_PREFIX 16 // Detected networks wider than this are narrowed to the local /24
+#ifndef CONNECT_TIMEOUT_MS
+#define CONNECT_TIMEOUT_MS 200
+#endif
+#define NEIGHBOR_PING_TIMEOUT_MS 500 // Replies to the IPv6 all-nodes ping collected this long
+#ifndef MONITOR_INTERVAL_S
+#define MONITOR_INTERVAL_S 5 // Default per-host probe interval
+#endif
+#define DEFAULT_JITTER_PERCENT 20 // Each interval is randomized by up to +/- this much
+#define UNSTABLE_SPEEDUP 2 // UNSTABLE hosts are re-probed this many times faster
+#define MAX_DOWN_BACKOFF_S 120 // DOWN hosts back off exponentially up to this interval
+#define MONITOR_COALESCE_MS 100 // Hosts due this close together share one probe batch
+#ifndef MONITOR_BATCH_MAX
+#define MONITOR_BATCH_MAX 1024 // Hosts per probe batch
+#endif
+#ifndef PING_FAIL_THRESHOLD
+#define PING_FAIL_THRESHOLD 3
+#endif
+#define HOSTNAME_RESOLVING "Resolving..." // Shown until the resolver pool answers
+#define HOST_DETAIL_CHUNK 256 // Details per chunk; a chunk never moves once allocated
+
+// --- Enums and Structs ---
+typedef enum {
+    STATUS_SCANNING,
+    STATUS_UP,
+    STATUS_UNSTABLE,
+    STATUS_DOWN
+} HostStatus;
+
+#define HOST_FLAG_PINNED 0x1 // Sorts after every address (the internet check)
+#define HOST_FLAG_REMOTE 0x2 // Reported by an agent (collector.c); never probed here
+#define HOST_FLAG_EXPIRED 0x4 // Aged out; removed at the end of the probe batch
+
+#define HOST_FAILURES_MAX 0xFFFF // consecutive_failures stops counting here
+
+// What the summary counts, sorts and every frame read: kept to 32 bytes so
+// those passes walk contiguous memory and inserts move little.
+typedef struct {
+    const char* hostname; // Interned in host_names, so it never moves or dangles
+    uint32_t addr; // Host id (hostaddr.h); format_host_addr() for display
+    uint8_t status; // HostStatus
+    uint8_t flags; // HOST_FLAG_*
+    uint16_t consecutive_failures; // Saturates at HOST_FAILURES_MAX
+    uint32_t rtt_avg_us; // Mean of the RTT history, RTT_LOST until the host answers
+    float flash_timer; // For status change animation
+    uint32_t detail; // Slot for host_detail(); fixed for the host's lifetime
+} MonitoredHost;
+_Static_assert(sizeof(MonitoredHost) <= 32, "MonitoredHost outgrew half a cache line; move the new field to HostDetail");
+
+// Per-host state only probing and the detail views need. Details live in
+// fixed-size chunks that are never moved or copied, so the table grows
+// without touching them and a removed host's slot is reused by the next one.
+typedef struct {
+    PortList ports; // Probe order; the last port that answered moves to the front
+    RttHistory rtt; // Latest answered probes
+    RttTimeline timeline; // Coarse long-term RTT and loss, for the detail view
+    uint32_t probes_total;   // Monitoring rounds since discovery
+    uint32_t failures_total; // Rounds in which no probe method got an answer
+    uint64_t down_since_ms; // monotonic_ms() when the host last went DOWN, for --age-out
+} HostDetail;
+
+// Shared work queue for discovery. Workers claim chunks of hosts with an
+// atomic add, so a slice full of dead hosts no longer holds up the sweep.
+typedef struct {
+    uint64_t next_index; // Next unclaimed address index into scan_targets
+    int chunk_hosts;     // Hosts claimed per grab, each with all its ports
+    int window;          // Probes each worker keeps in flight
+} DiscoveryQueue;
+
+// Scanner internals for the metrics endpoint. Fields are written with
+// __atomic builtins and may be read from any thread the same way.
+typedef struct {
+    uint64_t lock_acquisitions; // host_list_lock() calls
+    uint64_t lock_contended;    // Calls that had to wait
+    uint64_t lock_wait_us;      // Total time spent waiting
+    uint64_t batches;           // Monitoring batches published
+    uint64_t last_batch_us;     // Probe and publish time of the latest batch
+    uint64_t discovery_us;      // Length of the initial sweep, 0 until it ends
+} MonitorStats;
+
+// A host entering the table (old_status STATUS_SCANNING) or changing status.
+// Copied out of the table so it can be reported without host_list_mutex.
+typedef struct {
+    uint32_t addr;
+    char ip[HOST_ADDR_STRLEN];
+    char hostname[256];
+    HostStatus old_status;
+    HostStatus new_status;
+    int consecutive_failures;
+    RttStats rtt;
+} StatusChange;
+
+// Called on the event dispatch thread (see events.h) after the notify sinks,
+// with changes in the order they happened.
+typedef void (*StatusChangeHook)(const StatusChange* changes, int count);
+
+// Called with no lock held whenever anything shown in the host table changed:
+// a host added, a probe batch published, a hostname resolved. May run on any
+// monitor thread.
+typedef void (*HostTableHook)(void);
+
+// --- Shared State ---
+// The host table, its details, names and index are guarded by host_list_mutex.
+// discovered_hosts is always in host_order_key() order.
+extern MonitoredHost* discovered_hosts;
+extern HostDetail** host_detail_chunks; // Chunk n holds slots n * HOST_DETAIL_CHUNK onwards
+extern StringArena host_names;
+extern int discovered_hosts_count;
+extern int discovered_hosts_capacity;
+extern HostIndex host_index; // addr -> detail slot; host_row() finds the row
+extern bool discovery_complete; // The first sweep has finished
+extern volatile bool rediscovery_active; // A background sweep is running beside monitoring
+extern TargetSpec scan_targets; // Address ranges to discover
+extern char active_subnet[64]; // Short description of scan_targets for display
+extern pthread_mutex_t host_list_mutex;
+extern unsigned int host_table_version; // Bumped under host_list_mutex whenever a host is added, moved or updated
+extern volatile bool app_is_running;
+extern MonitorStats monitor_stats;
+extern HostTableHook host_table_hook; // Optional, set before monitor_start()
+extern StatusChangeHook status_change_hook; // Optional, set before monitor_start()
+
+// Returns the detail in slot, a host's detail field. Caller holds host_list_mutex.
+static inline HostDetail* host_detail(uint32_t slot) {
+    return &host_detail_chunks[slot / HOST_DETAIL_CHUNK][slot % HOST_DETAIL_CHUNK];
+}
+
+// --- Lifecycle ---
+// Starts the resolver pool and the network thread. Discovery runs at startup
+// and then every rediscover_interval_s beside monitoring.
+bool monitor_start(void);
+// Stops and joins the network thread, then the resolver pool.
+void monitor_stop(void);
+// Frees the host table and scan state once the network thread is gone.
+void monitor_cleanup(void);
+
+// --- Host Table ---
+// Locks host_list_mutex, accounting any wait in monitor_stats.
+void host_list_lock(void);
+// Unlocks it; traced builds also record how long it was held.
+void host_list_unlock(void);
+void* network_thread_main(void* arg);
+void add_host_to_list(uint32_t addr, uint16_t open_port, const char* hostname_override);
+void on_hostname_resolved(uint32_t addr, const char* hostname, void* ctx);
+// Display order of the table: IPv4 by address, then IPv6 in the order they
+// were found, pinned hosts last.
+uint64_t host_order_key(const MonitoredHost* host);
+// Row of addr in discovered_hosts, or -1 when it is not in the table.
+// Caller holds host_list_mutex.
+int host_row(uint32_t addr);
+const char* host_status_name(HostStatus status);
+bool get_local_ip_and_subnet(uint32_t* network, int* prefix_len);
+// Saves the host table to inventory_path (--cache). Safe from any thread.
+bool save_inventory(void);
+
+// --- Remote Hosts ---
+// Called by the collector for hosts its agents report. id is a remote id
+// (hostaddr.h). Adds the host if new, otherwise takes over what the agent
+// saw, publishing a status change like a local probe would.
+void monitor_merge_remote(uint32_t id, const char* hostname, HostStatus status, int consecutive_failures, uint32_t rtt_avg_us);
+// Drops a host its agent stopped reporting.
+void monitor_remove_remote(uint32_t id);
+
+#endif
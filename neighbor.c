@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe_backend.h"
+
+#ifdef _WIN32
+#include <iphlpapi.h>
+#else
+#include <ifaddrs.h>
+#include <net/if.h>
+#endif
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+#endif
+
+#include "hostaddr.h"
+#include "hostindex.h"
+#include "neighbor.h"
+#include "timeutil.h"
+
+#if defined(__linux__) && !defined(NDA_RTA)
+// Only the kernel's own copy of linux/neighbour.h defines this one
+#define NDA_RTA(r) ((struct rtattr*)(((char*)(r)) + NLMSG_ALIGN(sizeof(struct ndmsg))))
+#endif
+
+#define NEIGHBOR_MAX_INTERFACES 16
+#define NEIGHBOR_DUMP_BUFFER 16384 // Bytes read per netlink recv
+
+// Maps a neighbor address to its host id, or 0 for addresses that are not a
+// single host: multicast, broadcast, unspecified and loopback.
+static uint32_t neighbor_id(int family, const void* data, size_t len, uint32_t ifindex) {
+    if (family == AF_INET && len == 4) {
+        uint32_t addr;
+        memcpy(&addr, data, 4);
+        addr = ntohl(addr);
+        if (host_id_is_ipv6(addr) || host_id_is_remote(addr) || (addr >> 28) == 0xE) return 0;
+        if ((addr >> 24) == 127) return 0;
+        return addr;
+    }
+    if (family == AF_INET6 && len == 16) {
+        struct in6_addr addr;
+        memcpy(&addr, data, 16);
+        if (IN6_IS_ADDR_MULTICAST(&addr) || IN6_IS_ADDR_UNSPECIFIED(&addr) || IN6_IS_ADDR_LOOPBACK(&addr)) return 0;
+        return host_id_for_ipv6(&addr, ifindex);
+    }
+    return 0;
+}
+
+// --- Neighbor Table ---
+#if defined(__linux__)
+int neighbor_table_read(int family, NeighborCallback callback, void* ctx) {
+    int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (sock < 0) return -1;
+
+    struct {
+        struct nlmsghdr header;
+        struct ndmsg message;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = 1;
+    request.message.ndm_family = (unsigned char)family;
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(sock, &request, request.header.nlmsg_len, 0, (struct sockaddr*)&kernel, sizeof(kernel)) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    uint32_t buffer[NEIGHBOR_DUMP_BUFFER / sizeof(uint32_t)]; // Aligned for nlmsghdr
+    int reported = 0;
+    bool done = false;
+    while (!done) {
+        ssize_t received = recv(sock, buffer, sizeof(buffer), 0);
+        if (received <= 0) break;
+        unsigned int len = (unsigned int)received;
+        for (struct nlmsghdr* header = (struct nlmsghdr*)buffer; NLMSG_OK(header, len); header = NLMSG_NEXT(header, len)) {
+            if (header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type != RTM_NEWNEIGH) continue;
+
+            // Skip entries that never resolved, failed, or are not real neighbors
+            struct ndmsg* message = NLMSG_DATA(header);
+            if (message->ndm_state == NUD_NONE || (message->ndm_state & (NUD_INCOMPLETE | NUD_FAILED | NUD_NOARP))) continue;
+
+            int attr_len = (int)header->nlmsg_len - (int)NLMSG_LENGTH(sizeof(*message));
+            for (struct rtattr* attr = NDA_RTA(message); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type != NDA_DST) continue;
+                uint32_t id = neighbor_id(message->ndm_family, RTA_DATA(attr), RTA_PAYLOAD(attr), (uint32_t)message->ndm_ifindex);
+                if (id != 0) {
+                    callback(id, ctx);
+                    reported++;
+                }
+            }
+        }
+    }
+    close(sock);
+    return reported;
+}
+#elif defined(_WIN32)
+int neighbor_table_read(int family, NeighborCallback callback, void* ctx) {
+    PMIB_IPNET_TABLE2 table = NULL;
+    if (GetIpNetTable2((ADDRESS_FAMILY)family, &table) != NO_ERROR) return -1;
+
+    int reported = 0;
+    for (ULONG i = 0; i < table->NumEntries; i++) {
+        const MIB_IPNET_ROW2* row = &table->Table[i];
+        if (row->State == NlnsUnreachable || row->State == NlnsIncomplete || row->IsUnreachable) continue;
+
+        uint32_t id = 0;
+        if (row->Address.si_family == AF_INET) {
+            id = neighbor_id(AF_INET, &row->Address.Ipv4.sin_addr, 4, 0);
+        } else if (row->Address.si_family == AF_INET6) {
+            id = neighbor_id(AF_INET6, &row->Address.Ipv6.sin6_addr, 16, row->InterfaceIndex);
+        }
+        if (id != 0) {
+            callback(id, ctx);
+            reported++;
+        }
+    }
+    FreeMibTable(table);
+    return reported;
+}
+#else
+int neighbor_table_read(int family, NeighborCallback callback, void* ctx) {
+    (void)family;
+    (void)callback;
+    (void)ctx;
+    return -1; // No portable way to read the table here; discovery falls back to sweeping
+}
+#endif
+
+// --- All-Nodes Ping ---
+// Lists the indexes of the up, multicast-capable, non-loopback interfaces
+// with IPv6 enabled.
+#ifdef _WIN32
+static int neighbor_multicast_interfaces(unsigned int* out, int max) {
+    ULONG size = 16384;
+    ULONG flags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER;
+    IP_ADAPTER_ADDRESSES* adapters = malloc(size);
+    if (!adapters) return 0;
+    ULONG result = GetAdaptersAddresses(AF_INET6, flags, NULL, adapters, &size);
+    if (result == ERROR_BUFFER_OVERFLOW) {
+        free(adapters);
+        adapters = malloc(size);
+        if (!adapters) return 0;
+        result = GetAdaptersAddresses(AF_INET6, flags, NULL, adapters, &size);
+    }
+
+    int count = 0;
+    if (result == NO_ERROR) {
+        for (IP_ADAPTER_ADDRESSES* adapter = adapters; adapter != NULL && count < max; adapter = adapter->Next) {
+            if (adapter->OperStatus != IfOperStatusUp || adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK) continue;
+            if (adapter->NoMulticast || adapter->Ipv6IfIndex == 0) continue;
+            out[count++] = (unsigned int)adapter->Ipv6IfIndex;
+        }
+    }
+    free(adapters);
+    return count;
+}
+#else
+static int neighbor_multicast_interfaces(unsigned int* out, int max) {
+    struct ifaddrs *ifaddr, *ifa;
+    if (getifaddrs(&ifaddr) == -1) return 0;
+
+    int count = 0;
+    for (ifa = ifaddr; ifa != NULL && count < max; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET6) continue;
+        if (!(ifa->ifa_flags & IFF_UP) || !(ifa->ifa_flags & IFF_MULTICAST) || (ifa->ifa_flags & IFF_LOOPBACK)) continue;
+
+        unsigned int ifindex = if_nametoindex(ifa->ifa_name);
+        bool listed = (ifindex == 0);
+        for (int i = 0; i < count && !listed; i++) listed = (out[i] == ifindex);
+        if (!listed) out[count++] = ifindex; // One entry per interface, not per address
+    }
+    freeifaddrs(ifaddr);
+    return count;
+}
+#endif
+
+int neighbor_ping_all_nodes(int timeout_ms, NeighborCallback callback, void* ctx) {
+    bool raw;
+    probe_socket_t sock = icmp_open(AF_INET6, &raw);
+    if (sock == PROBE_INVALID_SOCKET) return -1;
+#ifdef _WIN32
+    uint16_t id = (uint16_t)(GetCurrentProcessId() ^ 0x6e64);
+#else
+    uint16_t id = (uint16_t)(getpid() ^ 0x6e64); // Apart from the per-batch ids in icmp.c
+#endif
+
+    unsigned int interfaces[NEIGHBOR_MAX_INTERFACES];
+    int interface_count = neighbor_multicast_interfaces(interfaces, NEIGHBOR_MAX_INTERFACES);
+    int sent = 0;
+    for (int i = 0; i < interface_count; i++) {
+        struct sockaddr_in6 dest;
+        memset(&dest, 0, sizeof(dest));
+        dest.sin6_family = AF_INET6;
+        dest.sin6_addr.s6_addr[0] = 0xff; // ff02::1, every node on the link
+        dest.sin6_addr.s6_addr[1] = 0x02;
+        dest.sin6_addr.s6_addr[15] = 0x01;
+        dest.sin6_scope_id = interfaces[i];
+
+        uint8_t packet[ICMP_ECHO_LEN];
+        icmp_build_echo(packet, true, id, (uint16_t)i);
+        if (sendto(sock, (const char*)packet, sizeof(packet), 0, (struct sockaddr*)&dest, sizeof(dest)) >= 0) sent++;
+    }
+    if (sent == 0) {
+        probe_close_socket(sock);
+        return 0;
+    }
+
+    HostIndex seen;
+    memset(&seen, 0, sizeof(seen));
+    int reported = 0;
+    uint64_t deadline_ms = monotonic_ms() + (uint64_t)timeout_ms;
+    for (;;) {
+        uint64_t now_ms = monotonic_ms();
+        if (now_ms >= deadline_ms) break;
+        if (!probe_wait_readable(sock, (int)(deadline_ms - now_ms))) continue;
+
+        for (;;) {
+            uint8_t reply[PROBE_PACKET_MAX];
+            struct sockaddr_in6 from;
+            socklen_t from_len = sizeof(from);
+            int len = (int)recvfrom(sock, (char*)reply, sizeof(reply), 0, (struct sockaddr*)&from, &from_len);
+            if (len < 0) break;
+            if (from.sin6_family != AF_INET6 || icmp_parse_reply(reply, len, true, raw, id) < 0) continue;
+
+            uint32_t host_id = neighbor_id(AF_INET6, &from.sin6_addr, 16, from.sin6_scope_id);
+            if (host_id == 0 || host_index_get(&seen, host_id) >= 0) continue;
+            host_index_put(&seen, host_id, 0);
+            callback(host_id, ctx);
+            reported++;
+        }
+    }
+    host_index_free(&seen);
+    probe_close_socket(sock);
+    return reported;
+}
@@ -0,0 +1,25 @@
+#ifndef NEIGHBOR_H
+#define NEIGHBOR_H
+
+#include <stdint.h>
+
+// --- Neighbor Discovery ---
+// Hosts the OS already knows are on the local segment: the kernel's ARP and
+// IPv6 neighbor cache, and whoever answers an ICMPv6 echo to the all-nodes
+// group. Both are cheap compared to sweeping a subnet, so discovery seeds
+// from them before probing address by address.
+
+// Called once per address found, with its host id (hostaddr.h).
+typedef void (*NeighborCallback)(uint32_t host_id, void* ctx);
+
+// Reports every reachable or recently reachable neighbor of family (AF_INET,
+// AF_INET6 or AF_UNSPEC for both). Returns how many were reported, or -1 when
+// the table cannot be read on this platform.
+int neighbor_table_read(int family, NeighborCallback callback, void* ctx);
+
+// Sends an ICMPv6 echo to ff02::1 on every multicast-capable interface and
+// reports each distinct source that answers within timeout_ms. Returns the
+// number of replies, or -1 when no ICMPv6 socket could be opened.
+int neighbor_ping_all_nodes(int timeout_ms, NeighborCallback callback, void* ctx);
+
+#endif
@@ -0,0 +1,63 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+
+#include "netutil.h"
+
+bool parse_host_port(const char* spec, bool host_required, char* host, size_t host_size, char* port, size_t port_size) {
+    const char* colon = strrchr(spec, ':');
+    if (host_required && (!colon || colon == spec)) return false;
+    const char* port_text = colon ? colon + 1 : spec;
+    size_t host_len = colon ? (size_t)(colon - spec) : 0;
+    size_t port_len = strlen(port_text);
+    if (host_len >= host_size || port_len == 0 || port_len >= port_size) return false;
+    for (const char* c = port_text; *c; c++) {
+        if (*c < '0' || *c > '9') return false;
+    }
+    memcpy(host, spec, host_len);
+    host[host_len] = '\0';
+    memcpy(port, port_text, port_len + 1);
+    return true;
+}
+
+net_socket_t open_listener(const char* host, const char* port, int backlog, const char* what) {
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE; // A bare port listens on every interface
+    int err = getaddrinfo(host[0] ? host : NULL, port, &hints, &result);
+    if (err != 0) {
+        printf("Could not resolve %s:%s to listen for %s on: %s\n", host, port, what, gai_strerror(err));
+        return NET_INVALID_SOCKET;
+    }
+
+    net_socket_t sock = NET_INVALID_SOCKET;
+    for (struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next) {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock == NET_INVALID_SOCKET) continue;
+        int reuse = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+        if (bind(sock, ai->ai_addr, (int)ai->ai_addrlen) == 0 && listen(sock, backlog) == 0) break;
+        net_close_socket(sock);
+        sock = NET_INVALID_SOCKET;
+    }
+    freeaddrinfo(result);
+
+    if (sock == NET_INVALID_SOCKET) printf("Could not listen for %s on %s:%s\n", what, host[0] ? host : "*", port);
+    return sock;
+}
+
+bool net_wait(net_socket_t sock, bool for_write, int timeout_ms) {
+    net_pollfd_t pfd = {sock, for_write ? POLLOUT : POLLIN, 0};
+    return net_poll(&pfd, 1, timeout_ms) > 0;
+}
+
+void net_no_sigpipe(net_socket_t sock) {
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#else
+    (void)sock;
+#endif
+}
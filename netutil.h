@@ -0,0 +1,59 @@
+#ifndef NETUTIL_H
+#define NETUTIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600 // WSAPoll needs Vista or later
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+typedef SOCKET net_socket_t;
+typedef WSAPOLLFD net_pollfd_t;
+#define net_poll WSAPoll
+#define NET_INVALID_SOCKET INVALID_SOCKET
+#define net_close_socket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int net_socket_t;
+typedef struct pollfd net_pollfd_t;
+#define net_poll poll
+#define NET_INVALID_SOCKET (-1)
+#define net_close_socket close
+#endif
+
+// --- Service Sockets ---
+// The metrics server, agent, collector and notify sinks share these. They
+// wait with poll(), never select(): with a high --concurrency the fd limit is
+// raised and a service socket opened beside the probes can be numbered past
+// FD_SETSIZE.
+
+#ifdef MSG_NOSIGNAL
+#define NET_SEND_FLAGS MSG_NOSIGNAL // A peer that went away is an error, not SIGPIPE
+#else
+#define NET_SEND_FLAGS 0 // net_no_sigpipe() covers BSD and macOS
+#endif
+
+// Splits "HOST:PORT" at the last colon into host and port. Without
+// host_required a bare "PORT" is accepted and leaves host empty. Nothing is
+// written unless the whole spec is valid and fits.
+bool parse_host_port(const char* spec, bool host_required, char* host, size_t host_size, char* port, size_t port_size);
+
+// Binds a TCP listener on host:port, every interface for an empty host.
+// what names the service in the message printed on failure.
+net_socket_t open_listener(const char* host, const char* port, int backlog, const char* what);
+
+// True once sock is readable (or writable), false on timeout or error.
+bool net_wait(net_socket_t sock, bool for_write, int timeout_ms);
+
+// Turns SIGPIPE off for sock where send() has no MSG_NOSIGNAL.
+void net_no_sigpipe(net_socket_t sock);
+
+#endif
@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <syslog.h>
+#endif
+
+#include "notify.h"
+#include "netutil.h"
+
+#define NOTIFY_LINE_MAX 512
+
+static pthread_mutex_t notify_mutex = PTHREAD_MUTEX_INITIALIZER; // Discovery workers report concurrently
+static bool use_stdout = false;
+static bool use_syslog = false;
+static char udp_host[256] = "";
+static char udp_port[8] = "";
+static net_socket_t udp_socket = NET_INVALID_SOCKET;
+static struct sockaddr_storage udp_addr;
+static socklen_t udp_addr_len = 0;
+
+void notify_enable_stdout(void) {
+    use_stdout = true;
+}
+
+bool notify_enable_syslog(void) {
+#ifdef _WIN32
+    return false;
+#else
+    use_syslog = true;
+    return true;
+#endif
+}
+
+bool notify_set_udp_target(const char* host_port) {
+    return parse_host_port(host_port, true, udp_host, sizeof(udp_host), udp_port, sizeof(udp_port));
+}
+
+static bool open_udp_sink(void) {
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    int err = getaddrinfo(udp_host, udp_port, &hints, &result);
+    if (err != 0) {
+        printf("Could not resolve notify target %s:%s: %s\n", udp_host, udp_port, gai_strerror(err));
+        return false;
+    }
+
+    for (struct addrinfo* ai = result; ai != NULL; ai = ai->ai_next) {
+        udp_socket = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (udp_socket == NET_INVALID_SOCKET) continue;
+        memcpy(&udp_addr, ai->ai_addr, ai->ai_addrlen);
+        udp_addr_len = (socklen_t)ai->ai_addrlen;
+        break;
+    }
+    freeaddrinfo(result);
+
+    if (udp_socket == NET_INVALID_SOCKET) {
+        printf("Could not open a UDP socket for %s:%s\n", udp_host, udp_port);
+        return false;
+    }
+    return true;
+}
+
+bool notify_start(void) {
+#ifndef _WIN32
+    if (use_syslog) openlog("netmonitor", LOG_PID, LOG_DAEMON);
+#endif
+    if (udp_host[0] && !open_udp_sink()) return false;
+    return true;
+}
+
+// Formats "<ip> <hostname> <OLD> -> <NEW>" without a timestamp; each sink adds its own.
+static int format_change(const StatusChange* change, char* buffer, size_t size) {
+    const char* hostname = change->hostname;
+    if (hostname[0] == '\0' || strcmp(hostname, HOSTNAME_RESOLVING) == 0) hostname = "-";
+    const char* old_name = (change->old_status == STATUS_SCANNING) ? "NEW" : host_status_name(change->old_status);
+    int len = snprintf(buffer, size, "%s %s %s -> %s", change->ip, hostname, old_name, host_status_name(change->new_status));
+    if (len > 0 && (size_t)len < size && change->consecutive_failures > 0) {
+        len += snprintf(buffer + len, size - len, " (failures=%d)", change->consecutive_failures);
+    } else if (len > 0 && (size_t)len < size && change->rtt.count > 0) {
+        len += snprintf(buffer + len, size - len, " (rtt avg=%.1fms p95=%.1fms jitter=%.1fms)",
+                        change->rtt.avg_us / 1000.0, change->rtt.p95_us / 1000.0, change->rtt.jitter_us / 1000.0);
+    }
+    return (len < 0) ? 0 : ((size_t)len >= size ? (int)size - 1 : len);
+}
+
+#ifndef _WIN32
+static int syslog_priority(const StatusChange* change) {
+    if (change->new_status == STATUS_DOWN) return LOG_WARNING;
+    if (change->old_status == STATUS_DOWN) return LOG_NOTICE;
+    return LOG_INFO;
+}
+#endif
+
+void notify_status_changes(const StatusChange* changes, int count) {
+    if (count <= 0 || (!use_stdout && !use_syslog && udp_socket == NET_INVALID_SOCKET)) return;
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &local);
+
+    pthread_mutex_lock(&notify_mutex);
+    for (int i = 0; i < count; i++) {
+        char line[NOTIFY_LINE_MAX];
+        int len = format_change(&changes[i], line, sizeof(line));
+
+        if (use_stdout) printf("%s %s\n", timestamp, line);
+#ifndef _WIN32
+        if (use_syslog) syslog(syslog_priority(&changes[i]), "%s", line);
+#endif
+        if (udp_socket != NET_INVALID_SOCKET) {
+            // Best effort: a lost datagram only costs one line at the collector
+            sendto(udp_socket, line, len, 0, (struct sockaddr*)&udp_addr, udp_addr_len);
+        }
+    }
+    if (use_stdout) fflush(stdout);
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+void notify_shutdown(void) {
+    pthread_mutex_lock(&notify_mutex);
+    if (udp_socket != NET_INVALID_SOCKET) {
+        net_close_socket(udp_socket);
+        udp_socket = NET_INVALID_SOCKET;
+    }
+#ifndef _WIN32
+    if (use_syslog) closelog();
+#endif
+    use_stdout = use_syslog = false;
+    pthread_mutex_unlock(&notify_mutex);
+}
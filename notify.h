@@ -0,0 +1,26 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdbool.h>
+
+#include "monitor.h"
+
+// --- Status Change Notifications ---
+// Writes one line of text per host status change to any enabled sink:
+// stdout, syslog (POSIX only) or UDP datagrams sent to a collector. Sinks are
+// configured from the command line and opened by notify_start().
+
+void notify_enable_stdout(void);
+bool notify_enable_syslog(void); // false where syslog is unavailable
+bool notify_set_udp_target(const char* host_port); // "host:port", checked only for shape here
+
+// Opens the enabled sinks. Resolves the UDP target, so on Windows it must run
+// after WSAStartup(). Returns false if a configured sink could not be opened.
+bool notify_start(void);
+
+// Safe to call from any thread.
+void notify_status_changes(const StatusChange* changes, int count);
+
+void notify_shutdown(void);
+
+#endif
@@ -0,0 +1,429 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include "options.h"
+#include "monitor.h"
+#include "notify.h"
+#include "metrics.h"
+#include "agent.h"
+#include "collector.h"
+#include "trace.h"
+
+const int COMMON_PORTS[] = {21, 22, 23, 80, 443, 445, 3389, 8080};
+const int NUM_COMMON_PORTS = sizeof(COMMON_PORTS) / sizeof(COMMON_PORTS[0]);
+
+// --- Globals ---
+int discovery_threads = 0; // 0 = pick from the core count
+int probe_concurrency = 0; // 0 = DEFAULT_PROBE_CONCURRENCY, always capped by the fd limit
+int monitor_interval_ms = MONITOR_INTERVAL_S * 1000;
+int monitor_jitter_percent = DEFAULT_JITTER_PERCENT;
+int latency_factor = DEFAULT_LATENCY_FACTOR;
+#ifdef NETMON_FIXED_PORTS
+const PortList default_ports = {{NETMON_FIXED_PORTS}, FIXED_PORT_COUNT};
+typedef char fixed_ports_fit[FIXED_PORT_COUNT <= MAX_HOST_PORTS ? 1 : -1]; // NETMON_FIXED_PORTS is too long
+#else
+PortList default_ports = {{0}, 0}; // Filled from COMMON_PORTS unless --ports replaces it
+#endif
+PortRule port_rules[MAX_PORT_RULES];
+int port_rule_count = 0;
+ProbeMethod probe_methods[PROBE_METHOD_COUNT] = {PROBE_METHOD_ICMP, PROBE_METHOD_TCP};
+int probe_method_count = 2;
+int starfield_fps = DEFAULT_STARFIELD_FPS;
+bool redraw_on_change = false;
+bool headless_mode = false;
+const char* inventory_path = NULL;
+int rediscover_interval_s = DEFAULT_REDISCOVER_S;
+int age_out_s = 0;
+bool ipv6_discovery = false;
+#ifndef NETMON_PROFILE
+int connect_timeout_ms = CONNECT_TIMEOUT_MS;
+int fail_threshold = PING_FAIL_THRESHOLD;
+#endif
+
+// --- Command Line and Runtime Limits ---
+void print_usage(const char* program) {
+    printf("Usage: %s [options] [targets]\n", program);
+#ifdef NETMON_PROFILE
+    printf("Built with the %s profile: ports, connect timeout and fail threshold are fixed\n", NETMON_PROFILE);
+#endif
+    printf("  targets             CIDR blocks or addresses, e.g. 10.0.0.0/20,10.8.0.0/24 or 192.168.1.\n");
+    printf("                      Lists given more than once, here or in --config, are combined\n");
+    printf("  --threads N         Discovery threads (default: one per core, up to %d)\n", DEFAULT_MAX_THREADS);
+    printf("  --concurrency N     Connects kept in flight (default: %d, capped by the fd limit)\n", DEFAULT_PROBE_CONCURRENCY);
+    printf("  --interval SECONDS  Probe interval per host (default: %d)\n", MONITOR_INTERVAL_S);
+    printf("  --jitter PERCENT    Random spread applied to each interval (default: %d)\n", DEFAULT_JITTER_PERCENT);
+    printf("  --latency-factor N  Mark hosts UNSTABLE when recent RTT exceeds N times their best, 0 = off (default: %d)\n", DEFAULT_LATENCY_FACTOR);
+    printf("  --ports [CIDR=]LIST Ports to probe, e.g. 22,443 or 10.0.5.0/24=3389 (repeatable)\n");
+    printf("  --timeout MS        TCP connect timeout per probe (default: %d)\n", CONNECT_TIMEOUT_MS);
+    printf("  --fail-threshold N  Missed probes in a row before a host is DOWN (default: %d)\n", PING_FAIL_THRESHOLD);
+    printf("  --probe LIST        Probe methods in order, from tcp, syn, icmp and arp (default: icmp,tcp)\n");
+    printf("  --syn-rate PPS      SYNs sent per second by the syn method, 0 = unlimited (default: %d)\n", SYN_DEFAULT_RATE);
+    printf("  --stars FPS         Starfield updates per second, 0 turns it off (default: %d)\n", DEFAULT_STARFIELD_FPS);
+    printf("  --redraw MODE       continuous (default) or on-change, which redraws only when hosts change\n");
+    printf("  --headless          Run without a window; status changes are printed to stdout\n");
+#ifndef _WIN32
+    printf("  --syslog            Also log status changes to syslog\n");
+#endif
+    printf("  --notify-udp H:PORT Also send each status change as a UDP datagram to H:PORT\n");
+    printf("  --config FILE       Read options from FILE, one \"name value\" per line; the command line wins\n");
+    printf("  --cache FILE        Save known hosts to FILE and monitor them at once on the next start\n");
+    printf("  --rediscover SECONDS Pause between background sweeps for new hosts, 0 = startup only (default: %d)\n", DEFAULT_REDISCOVER_S);
+    printf("  --age-out SECONDS   Stop monitoring hosts that have been DOWN this long, 0 = never (default: 0)\n");
+    printf("  --ipv6              Also discover IPv6 hosts from the neighbor table and an all-nodes ping\n");
+    printf("  --metrics [H:]PORT  Serve Prometheus metrics at http://H:PORT/metrics (all interfaces without H)\n");
+    printf("  --agent H:PORT      Stream host status changes to the collector at H:PORT\n");
+    printf("  --site NAME         Name this agent's hosts are shown under at the collector (default: host name)\n");
+    printf("  --collect [H:]PORT  Accept agents on PORT and show their hosts beside the local ones\n");
+#ifdef NETMON_TRACE
+    printf("  --trace FILE        Write a Chrome trace (Perfetto, chrome://tracing) of lock, frame and sweep spans at exit\n");
+#endif
+}
+
+// Reads a positive integer option value, printing an error when it is missing or malformed.
+bool parse_int_option(int argc, char* argv[], int* i, int min_value, int max_value, int* out) {
+    if (*i + 1 >= argc) {
+        printf("Missing value for %s\n", argv[*i]);
+        return false;
+    }
+    char* end;
+    long value = strtol(argv[*i + 1], &end, 10);
+    if (*end != '\0' || end == argv[*i + 1] || value < min_value || value > max_value) {
+        printf("Invalid value for %s: '%s' (expected %d-%d)\n", argv[*i], argv[*i + 1], min_value, max_value);
+        return false;
+    }
+    *out = (int)value;
+    (*i)++;
+    return true;
+}
+
+#ifndef NETMON_FIXED_PORTS
+// Parses "LIST" (replaces the default ports) or "CIDR=LIST" (adds a rule).
+bool parse_port_option(const char* value) {
+    const char* equals = strchr(value, '=');
+    if (!equals) return port_list_parse(value, &default_ports);
+
+    char cidr[32];
+    size_t len = (size_t)(equals - value);
+    if (len >= sizeof(cidr) || port_rule_count >= MAX_PORT_RULES) return false;
+    memcpy(cidr, value, len);
+    cidr[len] = '\0';
+
+    PortRule* rule = &port_rules[port_rule_count];
+    if (!parse_cidr(cidr, &rule->network, &rule->prefix_len) || !port_list_parse(equals + 1, &rule->ports)) return false;
+    port_rule_count++;
+    return true;
+}
+#endif
+
+// Parses a comma separated list of probe methods, e.g. "arp,icmp,tcp".
+bool parse_probe_option(const char* value) {
+    ProbeMethod methods[PROBE_METHOD_COUNT];
+    int count = 0;
+    const char* p = value;
+    while (*p) {
+        const char* end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        int found = -1;
+        for (int m = 0; m < PROBE_METHOD_COUNT; m++) {
+            const char* name = probe_method_name((ProbeMethod)m);
+            if (strlen(name) == len && strncmp(p, name, len) == 0) found = m;
+        }
+        if (found < 0) return false;
+        for (int i = 0; i < count; i++) {
+            if (methods[i] == (ProbeMethod)found) return false; // Each method at most once
+        }
+        methods[count++] = (ProbeMethod)found;
+        if (!end) break;
+        p = end + 1;
+    }
+    if (count == 0) return false;
+    memcpy(probe_methods, methods, sizeof(methods));
+    probe_method_count = count;
+    return true;
+}
+
+// Returns the port list of the most specific --ports rule covering addr,
+// or the default list.
+const PortList* ports_for_host(uint32_t addr) {
+    const PortList* best = &default_ports;
+    if (host_id_is_ipv6(addr)) return best; // Rules are IPv4 CIDR blocks
+    int best_prefix = -1;
+    for (int i = 0; i < port_rule_count; i++) {
+        const PortRule* rule = &port_rules[i];
+        uint32_t mask = (rule->prefix_len == 0) ? 0 : 0xFFFFFFFFu << (32 - rule->prefix_len);
+        if ((addr & mask) == rule->network && rule->prefix_len > best_prefix) {
+            best = &rule->ports;
+            best_prefix = rule->prefix_len;
+        }
+    }
+    return best;
+}
+
+#ifdef NETMON_PROFILE
+static bool fixed_by_profile(const char* option) {
+    printf("%s is fixed by the %s build profile\n", option, NETMON_PROFILE);
+    return false;
+}
+#endif
+
+// Applies the option at argv[*index], advancing *index past any value it
+// takes. Shared by the command line and the config file.
+static bool parse_option(int argc, char* argv[], int* index) {
+    int i = *index;
+    if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+        print_usage(argv[0]);
+        return false;
+    } else if (strcmp(argv[i], "--threads") == 0) {
+        if (!parse_int_option(argc, argv, &i, 1, MAX_DISCOVERY_THREADS, &discovery_threads)) return false;
+    } else if (strcmp(argv[i], "--concurrency") == 0) {
+        if (!parse_int_option(argc, argv, &i, 1, 65536, &probe_concurrency)) return false;
+    } else if (strcmp(argv[i], "--interval") == 0) {
+        int seconds;
+        if (!parse_int_option(argc, argv, &i, 1, 86400, &seconds)) return false;
+        monitor_interval_ms = seconds * 1000;
+    } else if (strcmp(argv[i], "--jitter") == 0) {
+        if (!parse_int_option(argc, argv, &i, 0, 90, &monitor_jitter_percent)) return false;
+    } else if (strcmp(argv[i], "--latency-factor") == 0) {
+        if (!parse_int_option(argc, argv, &i, 0, 1000, &latency_factor)) return false;
+    } else if (strcmp(argv[i], "--ports") == 0) {
+#ifdef NETMON_FIXED_PORTS
+        return fixed_by_profile(argv[i]);
+#else
+        if (i + 1 >= argc || !parse_port_option(argv[++i])) {
+            printf("Invalid value for --ports. Expected a list like 22,443 or 10.0.5.0/24=3389,22\n");
+            return false;
+        }
+#endif
+    } else if (strcmp(argv[i], "--timeout") == 0) {
+#ifdef NETMON_PROFILE
+        return fixed_by_profile(argv[i]);
+#else
+        if (!parse_int_option(argc, argv, &i, 1, 60000, &connect_timeout_ms)) return false;
+#endif
+    } else if (strcmp(argv[i], "--fail-threshold") == 0) {
+#ifdef NETMON_PROFILE
+        return fixed_by_profile(argv[i]);
+#else
+        if (!parse_int_option(argc, argv, &i, 1, 100, &fail_threshold)) return false;
+#endif
+    } else if (strcmp(argv[i], "--probe") == 0) {
+        if (i + 1 >= argc || !parse_probe_option(argv[++i])) {
+            printf("Invalid value for --probe. Expected a list like icmp,tcp using tcp, syn, icmp and arp\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--syn-rate") == 0) {
+        int rate;
+        if (!parse_int_option(argc, argv, &i, 0, 10000000, &rate)) return false;
+        probe_set_syn_rate(rate);
+    } else if (strcmp(argv[i], "--stars") == 0) {
+        if (!parse_int_option(argc, argv, &i, 0, 240, &starfield_fps)) return false;
+    } else if (strcmp(argv[i], "--redraw") == 0) {
+        if (i + 1 >= argc || (strcmp(argv[i + 1], "continuous") != 0 && strcmp(argv[i + 1], "on-change") != 0)) {
+            printf("Invalid value for --redraw. Expected continuous or on-change\n");
+            return false;
+        }
+        redraw_on_change = strcmp(argv[++i], "on-change") == 0;
+    } else if (strcmp(argv[i], "--headless") == 0) {
+        headless_mode = true;
+    } else if (strcmp(argv[i], "--syslog") == 0) {
+        if (!notify_enable_syslog()) {
+            printf("--syslog is not supported on this platform\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--notify-udp") == 0) {
+        if (i + 1 >= argc || !notify_set_udp_target(argv[++i])) {
+            printf("Invalid value for --notify-udp. Expected HOST:PORT, e.g. 10.0.0.2:5140\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--config") == 0) {
+        if (i + 1 >= argc) {
+            printf("Missing value for --config. Expected a file path\n");
+            return false;
+        }
+        i++; // Loaded by parse_arguments() before any other option
+    } else if (strcmp(argv[i], "--cache") == 0) {
+        if (i + 1 >= argc) {
+            printf("Missing value for --cache. Expected a file path\n");
+            return false;
+        }
+        inventory_path = argv[++i];
+    } else if (strcmp(argv[i], "--rediscover") == 0) {
+        if (!parse_int_option(argc, argv, &i, 0, 604800, &rediscover_interval_s)) return false;
+    } else if (strcmp(argv[i], "--age-out") == 0) {
+        if (!parse_int_option(argc, argv, &i, 0, 31536000, &age_out_s)) return false;
+    } else if (strcmp(argv[i], "--ipv6") == 0) {
+        ipv6_discovery = true;
+    } else if (strcmp(argv[i], "--metrics") == 0) {
+        if (i + 1 >= argc || !metrics_set_listen(argv[++i])) {
+            printf("Invalid value for --metrics. Expected PORT or HOST:PORT, e.g. 9108 or 127.0.0.1:9108\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--agent") == 0) {
+        if (i + 1 >= argc || !agent_set_collector(argv[++i])) {
+            printf("Invalid value for --agent. Expected HOST:PORT, e.g. collector.example.net:7400\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--site") == 0) {
+        if (i + 1 >= argc || !agent_set_site(argv[++i])) {
+            printf("Invalid value for --site. Expected 1-%d printable characters without spaces or '@'\n", AGENT_SITE_MAX);
+            return false;
+        }
+    } else if (strcmp(argv[i], "--collect") == 0) {
+        if (i + 1 >= argc || !collector_set_listen(argv[++i])) {
+            printf("Invalid value for --collect. Expected PORT or HOST:PORT, e.g. 7400 or 0.0.0.0:7400\n");
+            return false;
+        }
+    } else if (strcmp(argv[i], "--trace") == 0) {
+#ifdef NETMON_TRACE
+        if (i + 1 >= argc || !trace_set_output(argv[++i])) {
+            printf("Invalid value for --trace. Expected a file path\n");
+            return false;
+        }
+#else
+        printf("--trace needs a traced build: make clean && make TRACE=1\n");
+        return false;
+#endif
+    } else if (strncmp(argv[i], "--", 2) == 0) {
+        printf("Unknown option: %s\n", argv[i]);
+        print_usage(argv[0]);
+        return false;
+    } else {
+        // Every target list, from the config file or the command line, adds to the ones before it
+        TargetSpec parsed;
+        if (!target_spec_parse(argv[i], &parsed)) {
+            printf("Invalid subnet format provided: '%s'. It should be like '10.0.0.0/20,10.8.0.0/24' or '192.168.1.'\n", argv[i]);
+            return false;
+        }
+        bool added = target_spec_append(&scan_targets, &parsed);
+        target_spec_free(&parsed);
+        if (!added) {
+            printf("Out of memory adding targets '%s'\n", argv[i]);
+            return false;
+        }
+        target_spec_describe(&scan_targets, active_subnet, sizeof(active_subnet));
+        printf("Using user-provided targets: %s (%llu addresses)\n", active_subnet, (unsigned long long)scan_targets.total);
+    }
+    *index = i;
+    return true;
+}
+
+// Applies path, one option per line as "name value", "name = value" or just
+// "name" for a switch, using the command line names without the dashes:
+//   interval = 10
+//   ports 22,443
+//   headless
+// "targets" takes the same list as the command line. Blank lines and lines
+// starting with '#' are skipped.
+static bool load_config_file(const char* program, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Could not open config file %s\n", path);
+        return false;
+    }
+
+    char line[CONFIG_LINE_MAX];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* name = line + strspn(line, " \t");
+        name[strcspn(name, "\r\n")] = '\0';
+        if (*name == '\0' || *name == '#') continue;
+        char* value = name + strcspn(name, " \t=");
+        if (*value) {
+            *value++ = '\0';
+            value += strspn(value, " \t=");
+        }
+        size_t len = strlen(value);
+        while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) value[--len] = '\0';
+
+        // Kept for the life of the process: --cache and --trace hold on to the pointer
+        char* copy = strdup(value);
+        char option[CONFIG_LINE_MAX + 2];
+        snprintf(option, sizeof(option), "--%s", name);
+        char* args[3] = {(char*)program, option, copy};
+        int count = (len > 0) ? 3 : 2;
+        if (strcmp(name, "targets") == 0) {
+            args[1] = copy;
+            count = 2;
+        }
+        int index = 1;
+        if (!copy) {
+            ok = false;
+        } else if (strcmp(name, "config") == 0) {
+            printf("Config files cannot include other config files\n");
+            ok = false;
+        } else if (!parse_option(count, args, &index)) {
+            ok = false;
+        } else if (index != count - 1) {
+            printf("%s takes no value\n", name); // A switch such as "headless yes"
+            ok = false;
+        }
+        if (!ok) printf("Config file %s, line %d: could not apply '%s'\n", path, line_number, name);
+    }
+    fclose(file);
+    return ok;
+}
+
+bool parse_arguments(int argc, char* argv[]) {
+#ifndef NETMON_FIXED_PORTS
+    for (int i = 0; i < NUM_COMMON_PORTS && i < MAX_HOST_PORTS; i++) {
+        default_ports.ports[default_ports.count++] = (uint16_t)COMMON_PORTS[i];
+    }
+#endif
+
+    // The config file goes first, so the command line overrides anything in it
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && !load_config_file(argv[0], argv[i + 1])) return false;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!parse_option(argc, argv, &i)) return false;
+    }
+    return true;
+}
+
+// Fills in automatic thread and concurrency settings. Concurrency is capped
+// so every in-flight connect has a descriptor, raising the soft limit if needed.
+void configure_scan_limits(void) {
+    if (discovery_threads <= 0) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        discovery_threads = (int)info.dwNumberOfProcessors;
+#else
+        discovery_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (discovery_threads < 1) discovery_threads = 1;
+        if (discovery_threads > DEFAULT_MAX_THREADS) discovery_threads = DEFAULT_MAX_THREADS;
+    }
+    if (probe_concurrency <= 0) probe_concurrency = DEFAULT_PROBE_CONCURRENCY;
+
+#ifndef _WIN32
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        rlim_t wanted = (rlim_t)probe_concurrency + FD_RESERVE;
+        if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < wanted) {
+            limit.rlim_cur = (limit.rlim_max == RLIM_INFINITY || limit.rlim_max > wanted) ? wanted : limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < wanted) {
+            int cap = (int)limit.rlim_cur - FD_RESERVE;
+            probe_concurrency = cap > 1 ? cap : 1;
+            printf("Open file limit is %d; keeping at most %d connects in flight.\n", (int)limit.rlim_cur, probe_concurrency);
+        }
+    }
+#endif
+    if (discovery_threads > probe_concurrency) discovery_threads = probe_concurrency;
+    printf("Discovery: %d threads, %d connects in flight\n", discovery_threads, probe_concurrency);
+}
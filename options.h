@@ -0,0 +1,75 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "targets.h"
+#include "probe.h"
+
+// --- Command Line and Runtime Limits ---
+// Settings shared by the GUI and the headless daemon. Defaults are filled
+// in by parse_arguments() and configure_scan_limits().
+
+#define MAX_DISCOVERY_THREADS 64
+#ifndef DEFAULT_MAX_THREADS
+#define DEFAULT_MAX_THREADS 8 // Auto thread count is the core count, capped here
+#endif
+#ifndef DEFAULT_PROBE_CONCURRENCY
+#define DEFAULT_PROBE_CONCURRENCY 512 // Connects kept open at once across all probe batches
+#endif
+#define FD_RESERVE 64 // Descriptors left free for SDL, DNS and logging
+#define MAX_PORT_RULES 32 // --ports CIDR=LIST overrides
+#ifndef DEFAULT_STARFIELD_FPS
+#define DEFAULT_STARFIELD_FPS 60 // Background animation updates per second in the GUI
+#endif
+#define DEFAULT_LATENCY_FACTOR 3 // Recent RTT this many times the best marks a host UNSTABLE
+#define DEFAULT_REDISCOVER_S 600 // Pause between background sweeps for new hosts
+#define REDISCOVERY_SHARE 4 // Background sweeps get 1/N of probe_concurrency
+#define CONFIG_LINE_MAX 512 // Longest line in a --config file
+
+// Port list for every host inside network/prefix_len, from --ports CIDR=LIST
+typedef struct {
+    uint32_t network;
+    int prefix_len;
+    PortList ports;
+} PortRule;
+
+extern int discovery_threads; // 0 = pick from the core count
+extern int probe_concurrency; // 0 = DEFAULT_PROBE_CONCURRENCY, always capped by the fd limit
+extern int monitor_interval_ms;
+extern int monitor_jitter_percent;
+extern int latency_factor; // 0 = only failures make a host UNSTABLE
+#ifdef NETMON_FIXED_PORTS
+extern const PortList default_ports; // Set by the build profile; --ports is refused
+#else
+extern PortList default_ports; // Filled from COMMON_PORTS unless --ports replaces it
+#endif
+extern PortRule port_rules[MAX_PORT_RULES];
+extern int port_rule_count;
+extern ProbeMethod probe_methods[PROBE_METHOD_COUNT]; // Tried in order; each only sees hosts still unanswered
+extern int probe_method_count;
+extern int starfield_fps; // 0 = starfield off
+extern bool redraw_on_change; // --redraw on-change; the GUI idles until the host table changes
+extern bool headless_mode; // --headless; the netmonitord build sets it before parsing
+extern const char* inventory_path; // --cache FILE, NULL when warm start is off
+extern int rediscover_interval_s; // 0 = discover once at startup only
+extern int age_out_s; // Forget hosts DOWN this long; 0 = keep them forever
+extern bool ipv6_discovery; // --ipv6; seed discovery with IPv6 neighbors too
+#if defined(NETMON_FIXED_PORTS) && !defined(NETMON_PROFILE)
+#error "A build profile that sets NETMON_FIXED_PORTS must also name itself with NETMON_PROFILE"
+#endif
+#ifdef NETMON_PROFILE
+// Fixed by the build profile, so the probe loop compares against constants
+#define connect_timeout_ms CONNECT_TIMEOUT_MS
+#define fail_threshold PING_FAIL_THRESHOLD
+#else
+extern int connect_timeout_ms; // --timeout
+extern int fail_threshold; // --fail-threshold; misses in a row before a host is DOWN
+#endif
+
+bool parse_arguments(int argc, char* argv[]);
+void configure_scan_limits(void);
+const PortList* ports_for_host(uint32_t addr);
+
+#endif
@@ -0,0 +1,454 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe_backend.h"
+
+#ifndef _WIN32
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <poll.h>
+#endif
+
+#include "hostaddr.h"
+#include "timeutil.h"
+#include "trace.h"
+
+#if defined(__linux__)
+#define PROBE_USE_EPOLL 1
+#endif
+
+static uint64_t probes_launched = 0;  // Atomic; summed over all engines
+static int connects_in_flight = 0;    // Atomic
+
+// One in-flight connect. Free slots have target == -1.
+typedef struct {
+    probe_socket_t sock;
+    int target;
+    uint64_t deadline_ms;
+    uint64_t start_us; // When connect() was called, for the RTT
+} ProbeSlot;
+
+typedef struct {
+    const ProbeTarget* targets;
+    const ProbeOptions* options;
+    ProbeSlot* slots;
+    int* free_slots;
+    int free_count;
+    int in_flight;
+    bool* group_done;
+#ifdef PROBE_USE_EPOLL
+    int epoll_fd;
+    struct epoll_event* events;
+#elif defined(_WIN32)
+    WSAPOLLFD* pollfds;
+#else
+    struct pollfd* pollfds;
+#endif
+} ProbeEngine;
+
+int probe_last_error(void) {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool probe_set_nonblocking(probe_socket_t sock) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+    return fcntl(sock, F_SETFL, O_NONBLOCK) == 0;
+#endif
+}
+
+static ProbeOutcome probe_outcome_from_error(int err) {
+    if (err == 0) return PROBE_OPEN;
+#ifdef _WIN32
+    if (err == WSAECONNREFUSED) return PROBE_REFUSED;
+    if (err == WSAETIMEDOUT) return PROBE_TIMEOUT;
+#else
+    if (err == ECONNREFUSED) return PROBE_REFUSED;
+    if (err == ETIMEDOUT) return PROBE_TIMEOUT;
+#endif
+    return PROBE_ERROR;
+}
+
+static void probe_release_slot(ProbeEngine* engine, int slot_index) {
+    ProbeSlot* slot = &engine->slots[slot_index];
+    // Closing the socket also drops it from the epoll set.
+    probe_close_socket(slot->sock);
+    slot->sock = PROBE_INVALID_SOCKET;
+    slot->target = -1;
+#ifndef PROBE_USE_EPOLL
+    engine->pollfds[slot_index].fd = PROBE_INVALID_SOCKET;
+#endif
+    engine->free_slots[engine->free_count++] = slot_index;
+    engine->in_flight--;
+    __atomic_sub_fetch(&connects_in_flight, 1, __ATOMIC_RELAXED);
+}
+
+// Reports a finished probe and, if the callback resolves its group, drops
+// every other in-flight probe of that group.
+static void probe_report(ProbeEngine* engine, int target_index, ProbeOutcome outcome, uint32_t rtt_us) {
+    const ProbeTarget* target = &engine->targets[target_index];
+    ProbeResult result = {target, outcome, rtt_us};
+    if (outcome == PROBE_OPEN || outcome == PROBE_REFUSED) trace_record(TRACE_PROBE, trace_now() - rtt_us, rtt_us);
+    if (!engine->options->on_result(&result, engine->options->ctx)) return;
+
+    engine->group_done[target->group] = true;
+    for (int i = 0; i < engine->options->max_in_flight; i++) {
+        int other = engine->slots[i].target;
+        if (other >= 0 && engine->targets[other].group == target->group) {
+            probe_release_slot(engine, i);
+        }
+    }
+}
+
+static void probe_finish_slot(ProbeEngine* engine, int slot_index, ProbeOutcome outcome) {
+    int target_index = engine->slots[slot_index].target;
+    if (target_index < 0) return; // Already cancelled by an earlier result in this wakeup
+    uint32_t rtt_us = (outcome == PROBE_TIMEOUT) ? 0 : (uint32_t)(monotonic_us() - engine->slots[slot_index].start_us);
+    probe_release_slot(engine, slot_index);
+    probe_report(engine, target_index, outcome, rtt_us);
+}
+
+static void probe_launch(ProbeEngine* engine, int target_index) {
+    const ProbeTarget* target = &engine->targets[target_index];
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (!host_id_sockaddr(target->addr, target->port, &addr, &addr_len)) {
+        probe_report(engine, target_index, PROBE_ERROR, 0);
+        return;
+    }
+
+    probe_socket_t sock = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (sock == PROBE_INVALID_SOCKET) {
+        probe_report(engine, target_index, PROBE_ERROR, 0);
+        return;
+    }
+
+    if (!probe_set_nonblocking(sock)) {
+        probe_close_socket(sock);
+        probe_report(engine, target_index, PROBE_ERROR, 0);
+        return;
+    }
+
+    uint64_t start_us = monotonic_us();
+    if (connect(sock, (struct sockaddr*)&addr, addr_len) == 0) {
+        // Loopback and some local targets complete synchronously.
+        probe_close_socket(sock);
+        probe_report(engine, target_index, PROBE_OPEN, (uint32_t)(monotonic_us() - start_us));
+        return;
+    }
+
+    int err = probe_last_error();
+#ifdef _WIN32
+    if (err != WSAEWOULDBLOCK) {
+#else
+    if (err != EINPROGRESS) {
+#endif
+        probe_close_socket(sock);
+        probe_report(engine, target_index, probe_outcome_from_error(err), 0);
+        return;
+    }
+
+    int slot_index = engine->free_slots[--engine->free_count];
+    ProbeSlot* slot = &engine->slots[slot_index];
+
+#ifdef PROBE_USE_EPOLL
+    struct epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.u32 = (uint32_t)slot_index;
+    if (epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+        engine->free_count++;
+        probe_close_socket(sock);
+        probe_report(engine, target_index, PROBE_ERROR, 0);
+        return;
+    }
+#else
+    engine->pollfds[slot_index].fd = sock;
+    engine->pollfds[slot_index].events = POLLOUT;
+    engine->pollfds[slot_index].revents = 0;
+#endif
+
+    slot->sock = sock;
+    slot->target = target_index;
+    slot->deadline_ms = monotonic_ms() + (uint64_t)engine->options->timeout_ms;
+    slot->start_us = start_us;
+    engine->in_flight++;
+    __atomic_add_fetch(&connects_in_flight, 1, __ATOMIC_RELAXED);
+}
+
+static ProbeOutcome probe_socket_outcome(probe_socket_t sock) {
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len) != 0) return PROBE_ERROR;
+    return probe_outcome_from_error(so_error);
+}
+
+// Waits for connect completions until the earliest deadline and reports them.
+static void probe_wait(ProbeEngine* engine) {
+    uint64_t now = monotonic_ms();
+    uint64_t earliest = UINT64_MAX;
+    for (int i = 0; i < engine->options->max_in_flight; i++) {
+        if (engine->slots[i].target >= 0 && engine->slots[i].deadline_ms < earliest) {
+            earliest = engine->slots[i].deadline_ms;
+        }
+    }
+    int wait_ms = (earliest > now) ? (int)(earliest - now) : 0;
+
+#ifdef PROBE_USE_EPOLL
+    int ready = epoll_wait(engine->epoll_fd, engine->events, engine->options->max_in_flight, wait_ms);
+    for (int i = 0; i < ready; i++) {
+        int slot_index = (int)engine->events[i].data.u32;
+        if (engine->slots[slot_index].target < 0) continue;
+        probe_finish_slot(engine, slot_index, probe_socket_outcome(engine->slots[slot_index].sock));
+    }
+#else
+#ifdef _WIN32
+    int ready = WSAPoll(engine->pollfds, (ULONG)engine->options->max_in_flight, wait_ms);
+#else
+    int ready = poll(engine->pollfds, (nfds_t)engine->options->max_in_flight, wait_ms);
+#endif
+    for (int i = 0; ready > 0 && i < engine->options->max_in_flight; i++) {
+        if (engine->slots[i].target < 0 || engine->pollfds[i].revents == 0) continue;
+        ready--;
+        engine->pollfds[i].revents = 0;
+        probe_finish_slot(engine, i, probe_socket_outcome(engine->slots[i].sock));
+    }
+#endif
+
+    now = monotonic_ms();
+    for (int i = 0; i < engine->options->max_in_flight; i++) {
+        if (engine->slots[i].target >= 0 && engine->slots[i].deadline_ms <= now) {
+            probe_finish_slot(engine, i, PROBE_TIMEOUT);
+        }
+    }
+}
+
+static bool probe_engine_init(ProbeEngine* engine, const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    memset(engine, 0, sizeof(*engine));
+#ifdef PROBE_USE_EPOLL
+    engine->epoll_fd = -1;
+#endif
+    engine->targets = targets;
+    engine->options = options;
+
+    int group_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (targets[i].group >= group_count) group_count = targets[i].group + 1;
+    }
+
+    int slots = options->max_in_flight;
+    engine->slots = malloc(slots * sizeof(ProbeSlot));
+    engine->free_slots = malloc(slots * sizeof(int));
+    engine->group_done = calloc(group_count > 0 ? group_count : 1, sizeof(bool));
+    if (!engine->slots || !engine->free_slots || !engine->group_done) return false;
+#ifdef PROBE_USE_EPOLL
+    engine->events = malloc(slots * sizeof(struct epoll_event));
+    engine->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!engine->events || engine->epoll_fd < 0) return false;
+#else
+    engine->pollfds = calloc(slots, sizeof(*engine->pollfds));
+    if (!engine->pollfds) return false;
+#endif
+
+    for (int i = 0; i < slots; i++) {
+        engine->slots[i].sock = PROBE_INVALID_SOCKET;
+        engine->slots[i].target = -1;
+        engine->free_slots[i] = slots - 1 - i;
+#ifndef PROBE_USE_EPOLL
+        engine->pollfds[i].fd = PROBE_INVALID_SOCKET;
+#endif
+    }
+    engine->free_count = slots;
+    return true;
+}
+
+static void probe_engine_destroy(ProbeEngine* engine) {
+    // Only an early stop leaves connects open; in_flight is 0 if init failed.
+    for (int i = 0; engine->in_flight > 0 && i < engine->options->max_in_flight; i++) {
+        if (engine->slots[i].target >= 0) probe_release_slot(engine, i);
+    }
+#ifdef PROBE_USE_EPOLL
+    if (engine->epoll_fd >= 0) close(engine->epoll_fd);
+    free(engine->events);
+#else
+    free(engine->pollfds);
+#endif
+    free(engine->slots);
+    free(engine->free_slots);
+    free(engine->group_done);
+}
+
+int probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    if (!options || !options->on_result || options->max_in_flight <= 0) return -1;
+
+    ProbeEngine engine;
+    if (!probe_engine_init(&engine, targets, count, options)) {
+        probe_engine_destroy(&engine);
+        return -1;
+    }
+
+    int next = 0, launched = 0;
+    while (next < count || engine.in_flight > 0) {
+        if (options->keep_running && !*options->keep_running) break;
+
+        while (next < count && engine.free_count > 0) {
+            int target_index = next++;
+            if (engine.group_done[targets[target_index].group]) continue;
+            probe_launch(&engine, target_index);
+            launched++;
+        }
+
+        if (engine.in_flight > 0) probe_wait(&engine);
+    }
+
+    probe_engine_destroy(&engine);
+    __atomic_add_fetch(&probes_launched, (uint64_t)launched, __ATOMIC_RELAXED);
+    return launched;
+}
+
+// --- Packet Backends ---
+bool probe_wait_readable(probe_socket_t sock, int wait_ms) {
+#ifdef _WIN32
+    WSAPOLLFD pfd = {sock, POLLIN, 0};
+    return WSAPoll(&pfd, 1, wait_ms) > 0;
+#else
+    struct pollfd pfd = {sock, POLLIN, 0};
+    return poll(&pfd, 1, wait_ms) > 0;
+#endif
+}
+
+int probe_packet_batch(const PacketBackend* backend, const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    int group_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (targets[i].group >= group_count) group_count = targets[i].group + 1;
+    }
+    bool* answered = calloc(count, sizeof(bool));
+    bool* group_done = calloc(group_count > 0 ? group_count : 1, sizeof(bool));
+    uint64_t* sent_us = malloc(count * sizeof(uint64_t));
+    if (!answered || !group_done || !sent_us) {
+        free(answered);
+        free(group_done);
+        free(sent_us);
+        return -1;
+    }
+
+    int next = 0, pending = 0, launched = 0;
+    bool stopped = false;
+    uint64_t last_send_ms = monotonic_ms();
+    while (true) {
+        if (options->keep_running && !*options->keep_running) {
+            stopped = true;
+            break;
+        }
+
+        // Burst out as many requests as the socket buffer takes
+        while (next < count) {
+            if (group_done[targets[next].group]) {
+                answered[next++] = true;
+                continue;
+            }
+            sent_us[next] = monotonic_us();
+            PacketSendResult sent = backend->send(backend->state, &targets[next], next);
+            if (sent == PACKET_BLOCKED) break;
+            ProbeResult result = {&targets[next], PROBE_OPEN, 0};
+            if (sent == PACKET_SENT) {
+                pending++;
+                launched++;
+                last_send_ms = monotonic_ms();
+            } else {
+                answered[next] = true;
+                if (sent == PACKET_FAILED) result.outcome = PROBE_ERROR;
+                if (options->on_result(&result, options->ctx)) group_done[targets[next].group] = true;
+            }
+            next++;
+        }
+
+        uint64_t now = monotonic_ms();
+        uint64_t deadline = last_send_ms + (uint64_t)options->timeout_ms;
+        if (next == count && (pending == 0 || now >= deadline)) break;
+
+        // While requests are still queued, wake soon to retry the blocked send
+        int wait_ms = (next < count) ? 1 : (int)(deadline - now);
+        if (!probe_wait_readable(backend->sock, wait_ms)) continue;
+
+        int index;
+        ProbeOutcome outcome = PROBE_OPEN;
+        while ((index = backend->receive(backend->state, targets, next, &outcome)) != PACKET_DRAINED) {
+            ProbeOutcome reply = outcome;
+            outcome = PROBE_OPEN;
+            if (index < 0 || answered[index]) continue;
+            answered[index] = true;
+            pending--;
+            if (group_done[targets[index].group]) continue; // Resolved by another of its targets
+            ProbeResult result = {&targets[index], reply, (uint32_t)(monotonic_us() - sent_us[index])};
+            trace_record(TRACE_PROBE, sent_us[index], result.rtt_us);
+            if (options->on_result(&result, options->ctx)) group_done[targets[index].group] = true;
+        }
+    }
+
+    // An early stop reports nothing, the same as probe_batch()
+    for (int i = 0; !stopped && i < next; i++) {
+        if (answered[i] || group_done[targets[i].group]) continue;
+        ProbeResult result = {&targets[i], PROBE_TIMEOUT, 0};
+        options->on_result(&result, options->ctx);
+    }
+    free(answered);
+    free(group_done);
+    free(sent_us);
+    __atomic_add_fetch(&probes_launched, (uint64_t)launched, __ATOMIC_RELAXED);
+    return launched;
+}
+
+// --- Probe Methods ---
+int probe_method_batch(ProbeMethod method, const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    switch (method) {
+        case PROBE_METHOD_ICMP: return icmp_probe_batch(targets, count, options);
+        case PROBE_METHOD_ARP: return arp_probe_batch(targets, count, options);
+        case PROBE_METHOD_SYN: {
+            // Without raw sockets the same targets go through the connect engine
+            int sent = syn_probe_batch(targets, count, options);
+            return (sent >= 0) ? sent : probe_batch(targets, count, options);
+        }
+        default: return probe_batch(targets, count, options);
+    }
+}
+
+bool probe_method_available(ProbeMethod method) {
+    switch (method) {
+        case PROBE_METHOD_ICMP: return icmp_available();
+        case PROBE_METHOD_ARP: return arp_available();
+        case PROBE_METHOD_SYN: return syn_available();
+        default: return true;
+    }
+}
+
+uint64_t probe_total_launched(void) {
+    return __atomic_load_n(&probes_launched, __ATOMIC_RELAXED);
+}
+
+int probe_connects_in_flight(void) {
+    return __atomic_load_n(&connects_in_flight, __ATOMIC_RELAXED);
+}
+
+const char* probe_method_name(ProbeMethod method) {
+    switch (method) {
+        case PROBE_METHOD_ICMP: return "icmp";
+        case PROBE_METHOD_ARP: return "arp";
+        case PROBE_METHOD_SYN: return "syn";
+        default: return "tcp";
+    }
+}
+
+bool probe_method_uses_ports(ProbeMethod method) {
+    return method == PROBE_METHOD_TCP || method == PROBE_METHOD_SYN;
+}
@@ -0,0 +1,82 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Batch Connect Probe Engine ---
+// Keeps many non-blocking TCP connects in flight on the calling thread
+// (epoll on Linux, WSAPoll on Windows, poll() elsewhere) and reports each
+// probe through a callback as soon as it completes or times out, so a sweep
+// costs roughly one timeout instead of the sum of all of them.
+
+typedef enum {
+    PROBE_OPEN,    // Handshake completed
+    PROBE_REFUSED, // Host answered with a RST
+    PROBE_TIMEOUT, // No answer before the deadline
+    PROBE_ERROR    // Local failure or ICMP unreachable
+} ProbeOutcome;
+
+typedef struct {
+    uint32_t addr; // Host id (hostaddr.h): an IPv4 address in host byte order, or an IPv6 id
+    uint16_t port;
+    int group;     // Caller-defined id (>= 0), e.g. the host index
+} ProbeTarget;
+
+typedef struct {
+    const ProbeTarget* target;
+    ProbeOutcome outcome;
+    uint32_t rtt_us; // Send to answer on the monotonic clock; 0 for timeouts and local errors
+} ProbeResult;
+
+// Called once per finished probe. Returning true marks the probe's group as
+// resolved: its remaining queued and in-flight probes are dropped silently.
+typedef bool (*ProbeCallback)(const ProbeResult* result, void* ctx);
+
+typedef struct {
+    int timeout_ms;
+    int max_in_flight;
+    ProbeCallback on_result;
+    void* ctx;
+    const volatile bool* keep_running; // Optional; the batch stops early once this reads false
+} ProbeOptions;
+
+// Probes every target in order, keeping at most max_in_flight connects open.
+// Returns the number of probes launched, or -1 if the engine could not start.
+int probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options);
+
+// --- Probe Methods ---
+// TCP connects need no privilege but cost a socket and a handshake per port.
+// SYN probes the same ports with half-open handshakes from one raw socket.
+// ICMP echo and ARP send one packet per host and ignore ProbeTarget.port;
+// ARP only reaches hosts on a directly attached Ethernet segment.
+typedef enum {
+    PROBE_METHOD_TCP,
+    PROBE_METHOD_ICMP, // Unprivileged ping socket where allowed, else raw ICMP
+    PROBE_METHOD_ARP,  // Linux only, needs CAP_NET_RAW
+    PROBE_METHOD_SYN,  // Linux only, needs CAP_NET_RAW; falls back to TCP connects without it
+    PROBE_METHOD_COUNT
+} ProbeMethod;
+
+#define SYN_DEFAULT_RATE 50000 // SYNs per second across all threads
+#define SYN_BURST_US 2000 // Unused rate this old may still be spent at once
+
+// Same contract as probe_batch(), using the given method. Returns -1 when the
+// method is unavailable so the caller can fall back to the next one.
+int probe_method_batch(ProbeMethod method, const ProbeTarget* targets, int count, const ProbeOptions* options);
+
+// Checks once whether the method's socket can be opened with current privileges.
+bool probe_method_available(ProbeMethod method);
+
+const char* probe_method_name(ProbeMethod method);
+// True for the methods that probe each of a host's ports (tcp and syn).
+bool probe_method_uses_ports(ProbeMethod method);
+// --syn-rate: caps SYNs sent per second by the whole process, 0 = unlimited.
+void probe_set_syn_rate(int packets_per_second);
+
+// --- Engine Counters ---
+// Process-wide totals across every thread, read by the metrics endpoint.
+uint64_t probe_total_launched(void); // Connects and packets sent since start
+int probe_connects_in_flight(void);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef PROBE_BACKEND_H
+#define PROBE_BACKEND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600 // WSAPoll needs Vista or later
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+typedef SOCKET probe_socket_t;
+#define PROBE_INVALID_SOCKET INVALID_SOCKET
+#define probe_close_socket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+typedef int probe_socket_t;
+#define PROBE_INVALID_SOCKET (-1)
+#define probe_close_socket close
+#endif
+
+#include "probe.h"
+
+// --- Packet Probe Backends ---
+// Shared by the ICMP, ARP and SYN backends: one socket, a burst of one
+// request per target, and replies matched back to their target as they
+// arrive. Only the probe backends and neighbor.c include this header.
+
+#define PROBE_PACKET_MAX 1500 // Largest reply a backend is handed
+#define ICMP_ECHO_LEN 16      // Header plus padding of every echo request
+#define PROBE_RCVBUF_BYTES (1 << 20) // Room for a /16 worth of replies between reads
+
+typedef enum {
+    PACKET_SENT,     // Request is on the wire; wait for a reply
+    PACKET_BLOCKED,  // Socket buffer is full; retry after draining replies
+    PACKET_FAILED,   // Cannot be probed this way (reported as PROBE_ERROR)
+    PACKET_ANSWERED  // Known alive without sending, e.g. a local address
+} PacketSendResult;
+
+#define PACKET_NO_MATCH (-1) // Datagram was not a reply to this batch
+#define PACKET_DRAINED (-2)  // Nothing left to read
+
+typedef struct {
+    probe_socket_t sock;
+    void* state;
+    PacketSendResult (*send)(void* state, const ProbeTarget* target, int index);
+    // Reads one datagram and returns the index of the target it answers,
+    // PACKET_NO_MATCH, or PACKET_DRAINED once the socket would block. Sets
+    // *outcome only for answers other than PROBE_OPEN, e.g. a TCP reset.
+    int (*receive)(void* state, const ProbeTarget* targets, int count, ProbeOutcome* outcome);
+} PacketBackend;
+
+// Sends every request as fast as the socket accepts them, then collects
+// replies until timeout_ms after the last send. Answers are reported with
+// the outcome receive gives them, the rest as PROBE_TIMEOUT. max_in_flight
+// does not apply. A callback returning true resolves the target's group as
+// in probe_batch(): its unsent targets are skipped and late answers dropped.
+int probe_packet_batch(const PacketBackend* backend, const ProbeTarget* targets, int count, const ProbeOptions* options);
+
+bool probe_set_nonblocking(probe_socket_t sock);
+int probe_last_error(void);
+// Waits up to wait_ms for sock to become readable.
+bool probe_wait_readable(probe_socket_t sock, int wait_ms);
+
+// Opens an ICMP (AF_INET) or ICMPv6 (AF_INET6) socket: an unprivileged ping
+// socket where the OS offers one, else raw. *raw says which was opened.
+probe_socket_t icmp_open(int family, bool* raw);
+// Writes an ICMP_ECHO_LEN byte echo request into packet.
+void icmp_build_echo(uint8_t* packet, bool ipv6, uint16_t id, uint16_t seq);
+// Returns the sequence number of an echo reply, or -1 if packet is not one.
+// The id is only checked on raw sockets; ping sockets filter it themselves.
+int icmp_parse_reply(const uint8_t* packet, int len, bool ipv6, bool raw, uint16_t id);
+
+// Backend entry points, with the same contract as probe_batch(). They return
+// -1 when the socket cannot be opened, e.g. without the needed privilege.
+int icmp_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options);
+int arp_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options);
+int syn_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options);
+bool icmp_available(void);
+bool arp_available(void);
+bool syn_available(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef PROFILE_SENSOR_H
+#define PROFILE_SENSOR_H
+
+// --- Sensor Build Profile ---
+// For low-power ARM sensors that watch a few known services on a small
+// network: make clean && make headless PROFILE=sensor. The Makefile
+// force-includes this ahead of every source file, so each value replaces
+// the default in monitor.h or options.h and the matching option is refused
+// at run time. With the ports fixed every host's list is the same constant
+// table, and the probe loops run a constant number of times.
+
+#define NETMON_PROFILE "sensor"
+#define NETMON_FIXED_PORTS 22, 80, 443 // Tried in this order; replaces --ports
+#define CONNECT_TIMEOUT_MS 300 // Sensors often sit behind slow radio links
+#define PING_FAIL_THRESHOLD 3
+#define MONITOR_INTERVAL_S 15 // Default only; --interval still applies
+#define MONITOR_BATCH_MAX 128 // Smaller stack and per-batch buffers
+#define DEFAULT_MAX_THREADS 2
+#define DEFAULT_PROBE_CONCURRENCY 64
+#define DEFAULT_STARFIELD_FPS 0
+
+#endif
@@ -0,0 +1,235 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "hostaddr.h"
+#include "resolver.h"
+
+#define RESOLVER_MAX_THREADS 16
+#define RESOLVER_INITIAL_SLOTS 256 // Cache slots, always a power of two
+
+typedef enum {
+    ENTRY_EMPTY,
+    ENTRY_PENDING,  // Queued or being resolved, no answer yet
+    ENTRY_RESOLVED,
+    ENTRY_NO_NAME
+} ResolverEntryState;
+
+typedef struct {
+    uint32_t addr;
+    ResolverEntryState state;
+    bool refreshing; // A newer lookup is queued for an expired answer
+    time_t expires;
+    char hostname[256];
+} ResolverEntry;
+
+// --- Resolver State (guarded by resolver_mutex) ---
+static pthread_mutex_t resolver_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resolver_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t resolver_threads[RESOLVER_MAX_THREADS];
+static int resolver_thread_count = 0;
+static bool resolver_running = false;
+static ResolverCallback resolver_callback = NULL;
+static void* resolver_ctx = NULL;
+
+// Open-addressing cache keyed on the host id
+static ResolverEntry* cache_slots = NULL;
+static size_t cache_capacity = 0;
+static size_t cache_count = 0;
+
+// FIFO of addresses waiting for a lookup
+static uint32_t* queue = NULL;
+static size_t queue_head = 0;
+static size_t queue_count = 0;
+static size_t queue_capacity = 0;
+
+// Returns the slot for addr, or the empty slot where it would be inserted.
+static ResolverEntry* cache_find_slot(ResolverEntry* slots, size_t capacity, uint32_t addr) {
+    // Fibonacci hashing spreads consecutive addresses across the table
+    size_t i = (size_t)((addr * 2654435769u) & (capacity - 1));
+    while (slots[i].state != ENTRY_EMPTY && slots[i].addr != addr) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &slots[i];
+}
+
+static bool cache_grow() {
+    size_t new_capacity = cache_capacity ? cache_capacity * 2 : RESOLVER_INITIAL_SLOTS;
+    ResolverEntry* new_slots = calloc(new_capacity, sizeof(ResolverEntry));
+    if (!new_slots) return false;
+    for (size_t i = 0; i < cache_capacity; i++) {
+        if (cache_slots[i].state == ENTRY_EMPTY) continue;
+        *cache_find_slot(new_slots, new_capacity, cache_slots[i].addr) = cache_slots[i];
+    }
+    free(cache_slots);
+    cache_slots = new_slots;
+    cache_capacity = new_capacity;
+    return true;
+}
+
+static bool queue_push(uint32_t addr) {
+    if (queue_head + queue_count >= queue_capacity) {
+        if (queue_head > 0) {
+            memmove(queue, queue + queue_head, queue_count * sizeof(uint32_t));
+            queue_head = 0;
+        }
+        if (queue_count >= queue_capacity) {
+            size_t new_capacity = queue_capacity ? queue_capacity * 2 : 64;
+            uint32_t* new_queue = realloc(queue, new_capacity * sizeof(uint32_t));
+            if (!new_queue) return false;
+            queue = new_queue;
+            queue_capacity = new_capacity;
+        }
+    }
+    queue[queue_head + queue_count++] = addr;
+    return true;
+}
+
+static void* resolver_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&resolver_mutex);
+    while (resolver_running) {
+        if (queue_count == 0) {
+            pthread_cond_wait(&resolver_cond, &resolver_mutex);
+            continue;
+        }
+        uint32_t addr = queue[queue_head++];
+        if (--queue_count == 0) queue_head = 0;
+        pthread_mutex_unlock(&resolver_mutex);
+
+        struct sockaddr_storage sa;
+        socklen_t sa_len;
+        char hostname[256];
+        bool found = host_id_sockaddr(addr, 0, &sa, &sa_len) &&
+                     getnameinfo((struct sockaddr*)&sa, sa_len, hostname, sizeof(hostname), NULL, 0, NI_NAMEREQD) == 0;
+
+        pthread_mutex_lock(&resolver_mutex);
+        ResolverEntry* entry = cache_find_slot(cache_slots, cache_capacity, addr);
+        if (entry->state != ENTRY_EMPTY) {
+            entry->state = found ? ENTRY_RESOLVED : ENTRY_NO_NAME;
+            entry->refreshing = false;
+            entry->expires = time(NULL) + (found ? RESOLVER_TTL_S : RESOLVER_NEGATIVE_TTL_S);
+            if (found) memcpy(entry->hostname, hostname, sizeof(entry->hostname));
+        }
+        pthread_mutex_unlock(&resolver_mutex);
+
+        if (resolver_callback) resolver_callback(addr, found ? hostname : NULL, resolver_ctx);
+        pthread_mutex_lock(&resolver_mutex);
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+    return NULL;
+}
+
+bool resolver_init(int thread_count, ResolverCallback callback, void* ctx) {
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > RESOLVER_MAX_THREADS) thread_count = RESOLVER_MAX_THREADS;
+
+    pthread_mutex_lock(&resolver_mutex);
+    if (resolver_running || (!cache_slots && !cache_grow())) {
+        pthread_mutex_unlock(&resolver_mutex);
+        return false;
+    }
+    resolver_callback = callback;
+    resolver_ctx = ctx;
+    resolver_running = true;
+    pthread_mutex_unlock(&resolver_mutex);
+
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&resolver_threads[resolver_thread_count], NULL, resolver_worker, NULL) != 0) {
+            perror("Failed to create resolver thread");
+            break;
+        }
+        resolver_thread_count++;
+    }
+    if (resolver_thread_count == 0) {
+        pthread_mutex_lock(&resolver_mutex);
+        resolver_running = false;
+        pthread_mutex_unlock(&resolver_mutex);
+        return false;
+    }
+    return true;
+}
+
+void resolver_request(uint32_t addr) {
+    char cached[256];
+    bool deliver = false, found = false;
+
+    pthread_mutex_lock(&resolver_mutex);
+    if (!resolver_running) {
+        pthread_mutex_unlock(&resolver_mutex);
+        return;
+    }
+    // Keep the load factor under 70% so probe chains stay short
+    if ((cache_count + 1) * 10 > cache_capacity * 7 && !cache_grow()) {
+        pthread_mutex_unlock(&resolver_mutex);
+        return;
+    }
+
+    ResolverEntry* entry = cache_find_slot(cache_slots, cache_capacity, addr);
+    bool enqueue = false;
+    if (entry->state == ENTRY_EMPTY) {
+        entry->addr = addr;
+        entry->state = ENTRY_PENDING;
+        entry->refreshing = false;
+        cache_count++;
+        enqueue = true;
+    } else if (entry->state != ENTRY_PENDING) {
+        deliver = true;
+        found = entry->state == ENTRY_RESOLVED;
+        if (found) memcpy(cached, entry->hostname, sizeof(cached));
+        if (entry->expires <= time(NULL) && !entry->refreshing) {
+            entry->refreshing = true;
+            enqueue = true;
+        }
+    }
+    if (enqueue) {
+        if (queue_push(addr)) {
+            pthread_cond_signal(&resolver_cond);
+        } else {
+            // Out of memory: leave nothing PENDING that no worker will answer,
+            // so the next request for addr tries again
+            if (entry->state == ENTRY_PENDING) {
+                entry->state = ENTRY_NO_NAME;
+                entry->expires = 0;
+            }
+            entry->refreshing = false;
+        }
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (deliver && resolver_callback) resolver_callback(addr, found ? cached : NULL, resolver_ctx);
+}
+
+void resolver_shutdown(void) {
+    pthread_mutex_lock(&resolver_mutex);
+    resolver_running = false;
+    queue_head = queue_count = 0;
+    pthread_cond_broadcast(&resolver_cond);
+    pthread_mutex_unlock(&resolver_mutex);
+
+    for (int i = 0; i < resolver_thread_count; i++) {
+        pthread_join(resolver_threads[i], NULL);
+    }
+    resolver_thread_count = 0;
+
+    free(queue);
+    queue = NULL;
+    queue_capacity = 0;
+    free(cache_slots);
+    cache_slots = NULL;
+    cache_capacity = cache_count = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Asynchronous Reverse-DNS Resolver ---
+// A small pool of threads runs getnameinfo() so discovery never waits on DNS.
+// Answers, including "no PTR record", are cached with a TTL for the lifetime
+// of the process, so rescans of known hosts never hit the network again.
+
+#define RESOLVER_THREADS 4
+#define RESOLVER_TTL_S 3600         // How long a resolved name stays fresh
+#define RESOLVER_NEGATIVE_TTL_S 300 // How long a failed lookup is remembered
+
+// Called from a resolver thread (or from resolver_request() on a cache hit)
+// with no resolver lock held. hostname is NULL when the address has no name.
+typedef void (*ResolverCallback)(uint32_t addr, const char* hostname, void* ctx);
+
+bool resolver_init(int thread_count, ResolverCallback callback, void* ctx);
+
+// Queues a reverse lookup of addr, a host id (hostaddr.h). A fresh cached
+// answer is delivered immediately; a stale one is delivered and refreshed.
+void resolver_request(uint32_t addr);
+
+// Stops the pool once in-progress lookups return. Queued requests are dropped.
+void resolver_shutdown(void);
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtt.h"
+
+void rtt_record(RttHistory* history, uint32_t rtt_us) {
+    history->samples[history->next] = rtt_us;
+    history->next = (uint8_t)((history->next + 1) % RTT_HISTORY);
+    if (history->count < RTT_HISTORY) history->count++;
+}
+
+void rtt_clear(RttHistory* history) {
+    memset(history, 0, sizeof(*history));
+}
+
+// Returns the i-th sample counting back from the newest (0 = newest).
+static uint32_t rtt_sample_back(const RttHistory* history, int i) {
+    return history->samples[(history->next + RTT_HISTORY - 1 - i) % RTT_HISTORY];
+}
+
+uint32_t rtt_history_at(const RttHistory* history, int i) {
+    return rtt_sample_back(history, history->count - 1 - i);
+}
+
+void rtt_compute_stats(const RttHistory* history, RttStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    int count = history->count;
+    if (count == 0) return;
+
+    uint32_t sorted[RTT_HISTORY];
+    uint64_t sum = 0, jitter_sum = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t sample = rtt_sample_back(history, i);
+        sum += sample;
+        if (i > 0) {
+            uint32_t newer = rtt_sample_back(history, i - 1);
+            jitter_sum += (newer > sample) ? newer - sample : sample - newer;
+        }
+        // Insertion sort; the ring is small enough that this beats qsort
+        int j = i;
+        while (j > 0 && sorted[j - 1] > sample) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = sample;
+    }
+
+    stats->count = count;
+    stats->last_us = rtt_sample_back(history, 0);
+    stats->min_us = sorted[0];
+    stats->avg_us = (uint32_t)(sum / (uint64_t)count);
+    stats->p95_us = sorted[(count * 95 + 99) / 100 - 1]; // Nearest-rank percentile
+    stats->jitter_us = (count > 1) ? (uint32_t)(jitter_sum / (uint64_t)(count - 1)) : 0;
+}
+
+bool rtt_is_degraded(const RttHistory* history, int factor) {
+    if (factor <= 0 || history->count < RTT_MIN_SAMPLES) return false;
+
+    uint32_t min_us = UINT32_MAX;
+    for (int i = 0; i < history->count; i++) {
+        if (history->samples[i] < min_us) min_us = history->samples[i];
+    }
+    uint64_t recent = 0;
+    for (int i = 0; i < RTT_RECENT_SAMPLES; i++) recent += rtt_sample_back(history, i);
+    recent /= RTT_RECENT_SAMPLES;
+
+    return recent > (uint64_t)min_us * (uint64_t)factor && recent - min_us >= RTT_DEGRADE_MIN_US;
+}
+
+uint32_t rtt_average(const RttHistory* history) {
+    if (history->count == 0) return RTT_LOST;
+    uint64_t sum = 0;
+    for (int i = 0; i < history->count; i++) sum += history->samples[i];
+    return (uint32_t)(sum / (uint64_t)history->count);
+}
+
+void rtt_timeline_add(RttTimeline* timeline, bool answered, uint32_t rtt_us) {
+    timeline->pending_probes++;
+    if (answered) {
+        timeline->pending_answered++;
+        timeline->pending_sum_us += rtt_us;
+    }
+    if (timeline->pending_probes < RTT_TIMELINE_SPAN) return;
+
+    timeline->buckets[timeline->next] = timeline->pending_answered
+        ? (uint32_t)(timeline->pending_sum_us / timeline->pending_answered)
+        : RTT_LOST;
+    timeline->next = (uint8_t)((timeline->next + 1) % RTT_TIMELINE);
+    if (timeline->count < RTT_TIMELINE) timeline->count++;
+    timeline->pending_probes = timeline->pending_answered = 0;
+    timeline->pending_sum_us = 0;
+}
+
+void rtt_timeline_clear(RttTimeline* timeline) {
+    memset(timeline, 0, sizeof(*timeline));
+}
+
+uint32_t rtt_timeline_at(const RttTimeline* timeline, int i) {
+    return timeline->buckets[(timeline->next + RTT_TIMELINE - timeline->count + i) % RTT_TIMELINE];
+}
@@ -0,0 +1,69 @@
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Round-Trip Time History ---
+// Fixed-size ring of the latest probe RTTs per host. Recording is a store
+// and two increments, so it never allocates on the probe path; statistics
+// are computed from the ring when they are needed.
+
+#define RTT_HISTORY 32         // Samples kept per host
+#define RTT_MIN_SAMPLES 8      // Samples needed before latency can mark a host UNSTABLE
+#define RTT_RECENT_SAMPLES 3   // Latest samples averaged to detect a slowdown
+#define RTT_DEGRADE_MIN_US 20000 // Ignore slowdowns smaller than this, e.g. on a sub-ms LAN
+#define RTT_TIMELINE 60        // Buckets in the long timeline
+#define RTT_TIMELINE_SPAN 8    // Probes folded into each timeline bucket
+#define RTT_LOST UINT32_MAX    // Timeline bucket in which no probe was answered
+
+typedef struct {
+    uint32_t samples[RTT_HISTORY]; // Microseconds
+    uint8_t next;  // Slot the next sample goes into
+    uint8_t count; // Valid samples, up to RTT_HISTORY
+} RttHistory;
+
+typedef struct {
+    int count;
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p95_us;
+    uint32_t jitter_us; // Mean difference between consecutive samples
+} RttStats;
+
+// Longer, coarser view for the detail pane: each bucket holds the mean RTT of
+// RTT_TIMELINE_SPAN probes, or RTT_LOST if none of them was answered.
+typedef struct {
+    uint32_t buckets[RTT_TIMELINE];
+    uint8_t next;
+    uint8_t count;
+    uint8_t pending_probes;   // Probes folded into the bucket being filled
+    uint8_t pending_answered;
+    uint64_t pending_sum_us;
+} RttTimeline;
+
+void rtt_record(RttHistory* history, uint32_t rtt_us);
+void rtt_clear(RttHistory* history);
+
+// Returns the i-th sample counting from the oldest (0 <= i < count).
+uint32_t rtt_history_at(const RttHistory* history, int i);
+
+// Fills stats from the ring; every field is 0 when there are no samples.
+void rtt_compute_stats(const RttHistory* history, RttStats* stats);
+
+// True when the recent average exceeds factor times the fastest sample in
+// the ring. A factor of 0 disables the check.
+bool rtt_is_degraded(const RttHistory* history, int factor);
+
+// Mean of the history without the rest of rtt_compute_stats(); RTT_LOST when empty.
+uint32_t rtt_average(const RttHistory* history);
+
+// Adds one probe outcome; answered probes contribute rtt_us to the bucket mean.
+void rtt_timeline_add(RttTimeline* timeline, bool answered, uint32_t rtt_us);
+void rtt_timeline_clear(RttTimeline* timeline);
+
+// Returns the i-th completed bucket counting from the oldest.
+uint32_t rtt_timeline_at(const RttTimeline* timeline, int i);
+
+#endif
@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "scheduler.h"
+#include "timeutil.h"
+
+typedef struct {
+    uint64_t due_ms;
+    uint32_t addr;
+} ScheduledProbe;
+
+// --- Scheduler State (guarded by scheduler_mutex) ---
+static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scheduler_cond = PTHREAD_COND_INITIALIZER;
+static ScheduledProbe* heap = NULL;
+static int heap_count = 0;
+static int heap_capacity = 0;
+
+static void heap_swap(int a, int b) {
+    ScheduledProbe tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+}
+
+static void sift_up(int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].due_ms <= heap[i].due_ms) break;
+        heap_swap(parent, i);
+        i = parent;
+    }
+}
+
+static void sift_down(int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < heap_count && heap[left].due_ms < heap[smallest].due_ms) smallest = left;
+        if (right < heap_count && heap[right].due_ms < heap[smallest].due_ms) smallest = right;
+        if (smallest == i) break;
+        heap_swap(smallest, i);
+        i = smallest;
+    }
+}
+
+bool scheduler_add(uint32_t addr, uint64_t due_ms) {
+    pthread_mutex_lock(&scheduler_mutex);
+    if (heap_count >= heap_capacity) {
+        int new_capacity = heap_capacity ? heap_capacity * 2 : 64;
+        ScheduledProbe* grown = realloc(heap, new_capacity * sizeof(ScheduledProbe));
+        if (!grown) {
+            pthread_mutex_unlock(&scheduler_mutex);
+            return false;
+        }
+        heap = grown;
+        heap_capacity = new_capacity;
+    }
+    heap[heap_count].due_ms = due_ms;
+    heap[heap_count].addr = addr;
+    sift_up(heap_count++);
+    if (heap[0].addr == addr && heap[0].due_ms == due_ms) pthread_cond_signal(&scheduler_cond);
+    pthread_mutex_unlock(&scheduler_mutex);
+    return true;
+}
+
+static void wait_for_ms(uint64_t delay_ms) {
+    struct timespec deadline;
+    wall_clock_deadline(delay_ms, &deadline);
+    pthread_cond_timedwait(&scheduler_cond, &scheduler_mutex, &deadline);
+}
+
+int scheduler_wait_due(uint32_t* out, int max, uint64_t coalesce_ms, const volatile bool* keep_running) {
+    int n = 0;
+    pthread_mutex_lock(&scheduler_mutex);
+    while (*keep_running) {
+        uint64_t now = monotonic_ms();
+        if (heap_count == 0) {
+            pthread_cond_wait(&scheduler_cond, &scheduler_mutex);
+            continue;
+        }
+        if (heap[0].due_ms > now) {
+            wait_for_ms(heap[0].due_ms - now);
+            continue;
+        }
+        // Take everything due soon so nearby hosts share one probe batch
+        while (n < max && heap_count > 0 && heap[0].due_ms <= now + coalesce_ms) {
+            out[n++] = heap[0].addr;
+            heap[0] = heap[--heap_count];
+            sift_down(0);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&scheduler_mutex);
+    return n;
+}
+
+void scheduler_wake(void) {
+    pthread_mutex_lock(&scheduler_mutex);
+    pthread_cond_broadcast(&scheduler_cond);
+    pthread_mutex_unlock(&scheduler_mutex);
+}
+
+void scheduler_free(void) {
+    pthread_mutex_lock(&scheduler_mutex);
+    free(heap);
+    heap = NULL;
+    heap_count = heap_capacity = 0;
+    pthread_mutex_unlock(&scheduler_mutex);
+}
@@ -0,0 +1,26 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Probe Scheduler ---
+// Min-heap of hosts ordered by when they are next due for a probe. The
+// monitor thread sleeps on a condition variable until the earliest host is
+// due, so probe load follows each host's own interval instead of one burst.
+
+// Schedules addr, a host id (hostaddr.h), to be probed at due_ms on the
+// monotonic_ms() clock. Wakes the monitor if this is the new earliest entry.
+bool scheduler_add(uint32_t addr, uint64_t due_ms);
+
+// Blocks until at least one host is due or keep_running reads false, then
+// removes up to max hosts due within coalesce_ms of now. Returns how many
+// addresses were written to out (0 once keep_running is false).
+int scheduler_wait_due(uint32_t* out, int max, uint64_t coalesce_ms, const volatile bool* keep_running);
+
+// Wakes a waiting monitor thread, e.g. so it can notice shutdown.
+void scheduler_wake(void);
+
+void scheduler_free(void);
+
+#endif
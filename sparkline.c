@@ -0,0 +1,124 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sparkline.h"
+
+void sparkline_batch_reset(SparklineBatch* batch) {
+    batch->vertex_count = 0;
+    batch->index_count = 0;
+}
+
+// Makes room for that many more quads. Returns false if the buffers could not grow.
+static bool sparkline_reserve(SparklineBatch* batch, int quads) {
+    int vertices_needed = batch->vertex_count + quads * 4;
+    int indices_needed = batch->index_count + quads * 6;
+    if (vertices_needed > batch->vertex_capacity) {
+        int capacity = batch->vertex_capacity ? batch->vertex_capacity : 1024;
+        while (capacity < vertices_needed) capacity *= 2;
+        SDL_Vertex* vertices = realloc(batch->vertices, capacity * sizeof(SDL_Vertex));
+        if (!vertices) return false;
+        batch->vertices = vertices;
+        batch->vertex_capacity = capacity;
+    }
+    if (indices_needed > batch->index_capacity) {
+        int capacity = batch->index_capacity ? batch->index_capacity : 1536;
+        while (capacity < indices_needed) capacity *= 2;
+        int* indices = realloc(batch->indices, capacity * sizeof(int));
+        if (!indices) return false;
+        batch->indices = indices;
+        batch->index_capacity = capacity;
+    }
+    return true;
+}
+
+// Appends the quad (x0,y0)-(x1,y1) on top and the same edge pushed down by height.
+static void sparkline_quad(SparklineBatch* batch, float x0, float y0, float x1, float y1, float height, SDL_Color color) {
+    int base = batch->vertex_count;
+    SDL_Vertex* v = &batch->vertices[base];
+    v[0].position.x = x0; v[0].position.y = y0;
+    v[1].position.x = x1; v[1].position.y = y1;
+    v[2].position.x = x1; v[2].position.y = y1 + height;
+    v[3].position.x = x0; v[3].position.y = y0 + height;
+    for (int i = 0; i < 4; i++) {
+        v[i].color = color;
+        v[i].tex_coord.x = v[i].tex_coord.y = 0.0f;
+    }
+    batch->vertex_count += 4;
+
+    int* idx = &batch->indices[batch->index_count];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+    batch->index_count += 6;
+}
+
+static float sparkline_y(SDL_Rect area, uint32_t value, uint32_t max_value) {
+    float scaled = max_value ? (float)value / (float)max_value : 0.0f;
+    return (float)area.y + (float)area.h - SPARKLINE_THICKNESS - scaled * ((float)area.h - SPARKLINE_THICKNESS);
+}
+
+void sparkline_add_history(SparklineBatch* batch, const RttHistory* history, SDL_Rect area, SDL_Color color) {
+    int count = history->count;
+    if (count < 2 || !sparkline_reserve(batch, count - 1)) return;
+
+    uint32_t max_value = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t sample = rtt_history_at(history, i);
+        if (sample > max_value) max_value = sample;
+    }
+
+    // Right-aligned so a young host's short history ends where everyone's does
+    float step = (float)area.w / (float)(RTT_HISTORY - 1);
+    float x = (float)area.x + (float)area.w - step * (float)(count - 1);
+    float y = sparkline_y(area, rtt_history_at(history, 0), max_value);
+    for (int i = 1; i < count; i++) {
+        float next_y = sparkline_y(area, rtt_history_at(history, i), max_value);
+        sparkline_quad(batch, x, y, x + step, next_y, SPARKLINE_THICKNESS, color);
+        x += step;
+        y = next_y;
+    }
+}
+
+void sparkline_add_timeline(SparklineBatch* batch, const RttTimeline* timeline, SDL_Rect area, SDL_Color color, SDL_Color lost_color) {
+    int count = timeline->count;
+    if (count < 1 || !sparkline_reserve(batch, count)) return;
+
+    uint32_t max_value = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t bucket = rtt_timeline_at(timeline, i);
+        if (bucket != RTT_LOST && bucket > max_value) max_value = bucket;
+    }
+
+    float step = (float)area.w / (float)RTT_TIMELINE;
+    float x = (float)area.x + (float)area.w - step * (float)count;
+    for (int i = 0; i < count; i++) {
+        uint32_t bucket = rtt_timeline_at(timeline, i);
+        if (bucket == RTT_LOST) {
+            sparkline_quad(batch, x, (float)area.y, x + step, (float)area.y, (float)area.h, lost_color);
+        } else if (i + 1 < count && rtt_timeline_at(timeline, i + 1) != RTT_LOST) {
+            float y = sparkline_y(area, bucket, max_value);
+            float next_y = sparkline_y(area, rtt_timeline_at(timeline, i + 1), max_value);
+            sparkline_quad(batch, x + step / 2, y, x + step * 1.5f, next_y, SPARKLINE_THICKNESS, color);
+        } else {
+            // Isolated bucket between losses: a short flat tick keeps it visible
+            float y = sparkline_y(area, bucket, max_value);
+            sparkline_quad(batch, x, y, x + step, y, SPARKLINE_THICKNESS, color);
+        }
+        x += step;
+    }
+}
+
+void sparkline_batch_draw(SparklineBatch* batch, SDL_Renderer* renderer) {
+    if (batch->index_count == 0) return;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, NULL, batch->vertices, batch->vertex_count, batch->indices, batch->index_count);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+void sparkline_batch_free(SparklineBatch* batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->vertex_count = batch->index_count = 0;
+    batch->vertex_capacity = batch->index_capacity = 0;
+}
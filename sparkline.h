@@ -0,0 +1,39 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <SDL2/SDL.h>
+
+#include "rtt.h"
+
+// --- Batched Sparklines ---
+// Every latency graph in a frame is appended to one vertex buffer as thin
+// quads and submitted with a single SDL_RenderGeometry call, instead of one
+// draw call per point. The buffers are kept between frames, so a steady
+// frame allocates nothing.
+
+#define SPARKLINE_THICKNESS 1.5f // Line height in pixels
+
+typedef struct {
+    SDL_Vertex* vertices;
+    int* indices;
+    int vertex_count;
+    int index_count;
+    int vertex_capacity;
+    int index_capacity;
+} SparklineBatch;
+
+// Starts a new frame; keeps the allocated buffers.
+void sparkline_batch_reset(SparklineBatch* batch);
+
+// Appends the short RTT ring scaled to fit area.
+void sparkline_add_history(SparklineBatch* batch, const RttHistory* history, SDL_Rect area, SDL_Color color);
+
+// Appends the long timeline; buckets with no answer become full-height bars in lost_color.
+void sparkline_add_timeline(SparklineBatch* batch, const RttTimeline* timeline, SDL_Rect area, SDL_Color color, SDL_Color lost_color);
+
+// Draws everything appended since the last reset in one call.
+void sparkline_batch_draw(SparklineBatch* batch, SDL_Renderer* renderer);
+
+void sparkline_batch_free(SparklineBatch* batch);
+
+#endif
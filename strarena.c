@@ -0,0 +1,89 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strarena.h"
+#include "hostindex.h"
+
+#define STRING_CHUNK_SIZE 16384 // Bytes per chunk; longer strings get a chunk of their own
+#define STRING_ARENA_INITIAL_SLOTS 256
+
+struct StringChunk {
+    StringChunk* next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+static size_t hash_string(const char* text) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool grow(StringArena* arena) {
+    size_t new_capacity = arena->capacity ? arena->capacity * 2 : STRING_ARENA_INITIAL_SLOTS;
+    const char** new_slots = calloc(new_capacity, sizeof(const char*));
+    if (!new_slots) return false;
+
+    for (size_t i = 0; i < arena->capacity; i++) {
+        if (!arena->slots[i]) continue;
+        size_t slot = hash_string(arena->slots[i]) & (new_capacity - 1);
+        while (new_slots[slot]) slot = (slot + 1) & (new_capacity - 1);
+        new_slots[slot] = arena->slots[i];
+    }
+
+    free(arena->slots);
+    arena->slots = new_slots;
+    arena->capacity = new_capacity;
+    return true;
+}
+
+// Copies len bytes plus a terminator into the head chunk, starting a new one when full.
+static const char* store(StringArena* arena, const char* text, size_t len) {
+    StringChunk* chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < len + 1) {
+        size_t size = (len + 1 > STRING_CHUNK_SIZE) ? len + 1 : STRING_CHUNK_SIZE;
+        chunk = malloc(sizeof(StringChunk) + size);
+        if (!chunk) return NULL;
+        chunk->next = arena->chunks;
+        chunk->used = 0;
+        chunk->size = size;
+        arena->chunks = chunk;
+    }
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, text, len + 1);
+    chunk->used += len + 1;
+    return copy;
+}
+
+const char* string_arena_intern(StringArena* arena, const char* text) {
+    if (!HASH_HAS_ROOM(arena->count, arena->capacity) && !grow(arena)) return NULL;
+
+    size_t slot = hash_string(text) & (arena->capacity - 1);
+    while (arena->slots[slot]) {
+        if (strcmp(arena->slots[slot], text) == 0) return arena->slots[slot];
+        slot = (slot + 1) & (arena->capacity - 1);
+    }
+
+    const char* copy = store(arena, text, strlen(text));
+    if (!copy) return NULL;
+    arena->slots[slot] = copy;
+    arena->count++;
+    return copy;
+}
+
+void string_arena_free(StringArena* arena) {
+    StringChunk* chunk = arena->chunks;
+    while (chunk) {
+        StringChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena->slots);
+    memset(arena, 0, sizeof(*arena));
+}
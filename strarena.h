@@ -0,0 +1,26 @@
+#ifndef STRARENA_H
+#define STRARENA_H
+
+#include <stddef.h>
+
+// --- String Arena ---
+// Interns strings into large append-only chunks. An interned string never
+// moves or changes, so a pointer to it stays valid until the arena is freed,
+// and equal strings share one copy (every "Resolving..." is the same pointer).
+// Not thread-safe on its own; callers hold the lock that guards the arena.
+
+typedef struct StringChunk StringChunk;
+
+typedef struct {
+    StringChunk* chunks; // Newest first; only the head has free space
+    const char** slots;  // Open-addressing set of interned strings, NULL marks an empty slot
+    size_t capacity;     // Power of two
+    size_t count;
+} StringArena;
+
+// Returns the interned copy of text, or NULL if the arena could not grow.
+const char* string_arena_intern(StringArena* arena, const char* text);
+
+void string_arena_free(StringArena* arena);
+
+#endif
@@ -0,0 +1,258 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe_backend.h"
+#include "hostaddr.h"
+#include "timeutil.h"
+
+// --- SYN Backend ---
+// Half-open TCP probes from one raw socket: a SYN per (host, port), a
+// SYN-ACK reported as PROBE_OPEN and a reset as PROBE_REFUSED. The kernel
+// has no socket for the reply, so it resets every SYN-ACK itself and no
+// connection is ever set up. Each batch reserves a local port by binding an
+// unconnected TCP socket, and encodes the target index in the sequence
+// number, so replies are matched without any per-probe descriptor. Sends
+// are paced by one token bucket shared by every thread. Linux only: it
+// needs CAP_NET_RAW, and other systems do not pass TCP replies to raw
+// sockets. IPv6 targets always go through the connect engine.
+
+static int syn_rate = SYN_DEFAULT_RATE; // Packets per second, 0 = unlimited
+
+void probe_set_syn_rate(int packets_per_second) {
+    syn_rate = packets_per_second;
+}
+
+#ifdef __linux__
+#define SYN_HEADER_LEN 24  // TCP header plus the MSS option
+#define SYN_WINDOW 1024
+#define SYN_MSS 1460
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_ACK 0x10
+
+static uint64_t syn_next_send_us = 0; // Atomic; when the process may send its next SYN
+
+typedef struct {
+    probe_socket_t sock;       // Raw IPPROTO_TCP; the kernel adds the IP header
+    probe_socket_t port_sock;  // Holds local_port so no real connection reuses it
+    probe_socket_t route_sock; // UDP socket connected to look up source addresses
+    uint16_t local_port;
+    uint32_t seq_base;         // Target index i is sent with sequence seq_base + i
+    uint32_t route_prefix;     // /24 the cached source address was looked up for
+    uint32_t source_addr;      // Host byte order; 0 until looked up
+} SynState;
+
+// Claims a send slot from the process-wide token bucket, or returns false
+// when the rate is used up for now.
+static bool syn_take_send_slot(void) {
+    int rate = syn_rate;
+    if (rate <= 0) return true;
+    uint64_t interval_us = 1000000 / (uint64_t)rate;
+    if (interval_us == 0) interval_us = 1;
+    uint64_t now = monotonic_us();
+    uint64_t slot = __atomic_load_n(&syn_next_send_us, __ATOMIC_RELAXED);
+    uint64_t next;
+    do {
+        if (slot > now) return false;
+        uint64_t earliest = (now > SYN_BURST_US) ? now - SYN_BURST_US : 0;
+        next = ((slot > earliest) ? slot : earliest) + interval_us;
+    } while (!__atomic_compare_exchange_n(&syn_next_send_us, &slot, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
+}
+
+// Finds the local address the kernel would send to addr from. Targets of a
+// sweep share a few /24s, so the answer is cached per /24.
+static bool syn_source_for(SynState* syn, uint32_t addr) {
+    if (syn->source_addr != 0 && syn->route_prefix == (addr & 0xFFFFFF00u)) return true;
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(9); // Any port; connecting a UDP socket sends nothing
+    dest.sin_addr.s_addr = htonl(addr);
+    struct sockaddr_in local;
+    socklen_t local_len = sizeof(local);
+    if (connect(syn->route_sock, (struct sockaddr*)&dest, sizeof(dest)) < 0 ||
+        getsockname(syn->route_sock, (struct sockaddr*)&local, &local_len) < 0) {
+        return false;
+    }
+    syn->route_prefix = addr & 0xFFFFFF00u;
+    syn->source_addr = ntohl(local.sin_addr.s_addr);
+    return syn->source_addr != 0;
+}
+
+static void syn_put16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static void syn_put32(uint8_t* out, uint32_t value) {
+    syn_put16(out, (uint16_t)(value >> 16));
+    syn_put16(out + 2, (uint16_t)value);
+}
+
+// TCP checksum over the IPv4 pseudo-header and the segment.
+static uint16_t syn_checksum(uint32_t source, uint32_t dest, const uint8_t* segment, int len) {
+    uint32_t sum = (source >> 16) + (source & 0xFFFF) + (dest >> 16) + (dest & 0xFFFF) + IPPROTO_TCP + (uint32_t)len;
+    for (int i = 0; i + 1 < len; i += 2) sum += (uint32_t)(segment[i] << 8 | segment[i + 1]);
+    if (len & 1) sum += (uint32_t)segment[len - 1] << 8;
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+static PacketSendResult syn_send(void* state, const ProbeTarget* target, int index) {
+    SynState* syn = (SynState*)state;
+    if (host_id_is_ipv6(target->addr) || !syn_source_for(syn, target->addr)) return PACKET_FAILED;
+    if (!syn_take_send_slot()) return PACKET_BLOCKED;
+
+    uint8_t packet[SYN_HEADER_LEN];
+    syn_put16(packet, syn->local_port);
+    syn_put16(packet + 2, target->port);
+    syn_put32(packet + 4, syn->seq_base + (uint32_t)index);
+    syn_put32(packet + 8, 0);
+    packet[12] = (SYN_HEADER_LEN / 4) << 4;
+    packet[13] = TCP_FLAG_SYN;
+    syn_put16(packet + 14, SYN_WINDOW);
+    syn_put16(packet + 16, 0); // Checksum, filled in below
+    syn_put16(packet + 18, 0);
+    packet[20] = 2; // MSS option: some stacks drop a SYN without one
+    packet[21] = 4;
+    syn_put16(packet + 22, SYN_MSS);
+    syn_put16(packet + 16, syn_checksum(syn->source_addr, target->addr, packet, sizeof(packet)));
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = htonl(target->addr);
+    if (sendto(syn->sock, packet, sizeof(packet), 0, (struct sockaddr*)&dest, sizeof(dest)) >= 0) return PACKET_SENT;
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) ? PACKET_BLOCKED : PACKET_FAILED;
+}
+
+static int syn_receive(void* state, const ProbeTarget* targets, int count, ProbeOutcome* outcome) {
+    SynState* syn = (SynState*)state;
+    uint8_t packet[PROBE_PACKET_MAX];
+    ssize_t len = recv(syn->sock, packet, sizeof(packet), 0);
+    if (len < 0) return PACKET_DRAINED;
+
+    // Raw sockets see every incoming TCP segment, IP header included
+    if (len < 20 || (packet[0] >> 4) != 4 || packet[9] != IPPROTO_TCP) return PACKET_NO_MATCH;
+    int header_len = (packet[0] & 0x0F) * 4;
+    if (len < header_len + 20) return PACKET_NO_MATCH;
+    const uint8_t* tcp = packet + header_len;
+    if ((uint16_t)(tcp[2] << 8 | tcp[3]) != syn->local_port) return PACKET_NO_MATCH;
+
+    uint8_t flags = tcp[13];
+    if (!(flags & TCP_FLAG_ACK)) return PACKET_NO_MATCH;
+    uint32_t ack = (uint32_t)tcp[8] << 24 | (uint32_t)tcp[9] << 16 | (uint32_t)tcp[10] << 8 | tcp[11];
+    uint32_t index = ack - 1 - syn->seq_base;
+    if (index >= (uint32_t)count) return PACKET_NO_MATCH;
+
+    const ProbeTarget* target = &targets[index];
+    uint32_t source = (uint32_t)packet[12] << 24 | (uint32_t)packet[13] << 16 | (uint32_t)packet[14] << 8 | packet[15];
+    if (source != target->addr || (uint16_t)(tcp[0] << 8 | tcp[1]) != target->port) return PACKET_NO_MATCH;
+
+    if (flags & TCP_FLAG_RST) *outcome = PROBE_REFUSED;
+    else if (!(flags & TCP_FLAG_SYN)) return PACKET_NO_MATCH;
+    return (int)index;
+}
+
+static probe_socket_t syn_open(void) {
+    probe_socket_t sock = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+    if (sock == PROBE_INVALID_SOCKET) return sock;
+    int buffer_size = PROBE_RCVBUF_BYTES;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    if (!probe_set_nonblocking(sock)) {
+        close(sock);
+        return PROBE_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+// Binds a TCP socket to an ephemeral port without listening on it, and
+// returns the port, or 0 on failure.
+static uint16_t syn_reserve_port(probe_socket_t sock) {
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    socklen_t local_len = sizeof(local);
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0 ||
+        getsockname(sock, (struct sockaddr*)&local, &local_len) < 0) {
+        return 0;
+    }
+    return ntohs(local.sin_port);
+}
+
+// Probes targets that are all IPv4.
+static int syn_ipv4_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    SynState syn;
+    memset(&syn, 0, sizeof(syn));
+    syn.sock = syn_open();
+    syn.port_sock = socket(AF_INET, SOCK_STREAM, 0);
+    syn.route_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int sent = -1;
+    if (syn.sock != PROBE_INVALID_SOCKET && syn.port_sock != PROBE_INVALID_SOCKET && syn.route_sock != PROBE_INVALID_SOCKET) {
+        syn.local_port = syn_reserve_port(syn.port_sock);
+        syn.seq_base = (uint32_t)monotonic_us() * 2654435761u; // Unpredictable enough to ignore stale replies
+        if (syn.local_port != 0) {
+            PacketBackend backend = {syn.sock, &syn, syn_send, syn_receive};
+            sent = probe_packet_batch(&backend, targets, count, options);
+        }
+    }
+    if (syn.sock != PROBE_INVALID_SOCKET) close(syn.sock);
+    if (syn.port_sock != PROBE_INVALID_SOCKET) close(syn.port_sock);
+    if (syn.route_sock != PROBE_INVALID_SOCKET) close(syn.route_sock);
+    return sent;
+}
+
+int syn_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    if (count <= 0) return 0;
+    if (!options || !options->on_result) return -1;
+
+    int ipv6_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (host_id_is_ipv6(targets[i].addr)) ipv6_count++;
+    }
+    if (ipv6_count == 0) return syn_ipv4_batch(targets, count, options);
+    if (ipv6_count == count) return -1;
+
+    // Raw IPv6 TCP is not implemented: split the batch and connect to the IPv6 half
+    ProbeTarget* split = malloc(count * sizeof(ProbeTarget));
+    if (!split) return -1;
+    int ipv4_count = 0, next_ipv6 = count - ipv6_count;
+    for (int i = 0; i < count; i++) {
+        if (host_id_is_ipv6(targets[i].addr)) split[next_ipv6++] = targets[i];
+        else split[ipv4_count++] = targets[i];
+    }
+    int sent_ipv4 = syn_ipv4_batch(split, ipv4_count, options);
+    if (sent_ipv4 < 0) {
+        free(split);
+        return -1; // The caller connects to the whole batch instead
+    }
+    int sent_ipv6 = probe_batch(split + ipv4_count, ipv6_count, options);
+    free(split);
+    return sent_ipv4 + (sent_ipv6 > 0 ? sent_ipv6 : 0);
+}
+
+bool syn_available(void) {
+    probe_socket_t sock = syn_open();
+    if (sock == PROBE_INVALID_SOCKET) return false;
+    close(sock);
+    return true;
+}
+
+#else // TCP replies only reach raw sockets on Linux
+
+int syn_probe_batch(const ProbeTarget* targets, int count, const ProbeOptions* options) {
+    (void)targets;
+    (void)count;
+    (void)options;
+    return -1;
+}
+
+bool syn_available(void) {
+    return false;
+}
+
+#endif
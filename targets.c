@@ -0,0 +1,243 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "targets.h"
+#include "hostaddr.h"
+
+static int compare_ranges(const void* a, const void* b) {
+    const AddressRange* range_a = (const AddressRange*)a;
+    const AddressRange* range_b = (const AddressRange*)b;
+    if (range_a->first < range_b->first) return -1;
+    if (range_a->first > range_b->first) return 1;
+    return 0;
+}
+
+// Sorts the ranges, merges overlaps and recomputes the address count.
+static void normalize(TargetSpec* spec) {
+    if (spec->count == 0) {
+        spec->total = 0;
+        return;
+    }
+    qsort(spec->ranges, spec->count, sizeof(AddressRange), compare_ranges);
+    int out = 0;
+    for (int i = 1; i < spec->count; i++) {
+        AddressRange* last = &spec->ranges[out];
+        if ((uint64_t)spec->ranges[i].first <= (uint64_t)last->last + 1) {
+            if (spec->ranges[i].last > last->last) last->last = spec->ranges[i].last;
+        } else {
+            spec->ranges[++out] = spec->ranges[i];
+        }
+    }
+    spec->count = out + 1;
+    spec->total = 0;
+    for (int i = 0; i < spec->count; i++) {
+        spec->total += (uint64_t)spec->ranges[i].last - spec->ranges[i].first + 1;
+    }
+}
+
+bool target_spec_add_cidr(TargetSpec* spec, uint32_t network, int prefix_len) {
+    if (prefix_len < TARGET_MIN_PREFIX || prefix_len > 32) return false;
+
+    uint32_t mask = prefix_len == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix_len);
+    AddressRange range = {network & mask, (network & mask) | ~mask};
+    if (prefix_len <= 30) {
+        range.first++;
+        range.last--;
+    }
+    if (range.first < HOST_ID_IPV6_LIMIT || range.last >= HOST_ID_REMOTE_BASE) {
+        char ip[16];
+        struct in_addr in;
+        in.s_addr = htonl(network & mask);
+        inet_ntop(AF_INET, &in, ip, sizeof(ip));
+        printf("Target %s/%d overlaps 0.0.0.0/8 or 240.0.0.0/4, which are reserved for IPv6 and remote host ids\n", ip, prefix_len);
+        return false;
+    }
+
+    AddressRange* grown = realloc(spec->ranges, (spec->count + 1) * sizeof(AddressRange));
+    if (!grown) return false;
+    spec->ranges = grown;
+    spec->ranges[spec->count++] = range;
+    normalize(spec);
+    return true;
+}
+
+bool target_spec_append(TargetSpec* spec, const TargetSpec* more) {
+    if (more->count == 0) return true;
+    AddressRange* grown = realloc(spec->ranges, (spec->count + more->count) * sizeof(AddressRange));
+    if (!grown) return false;
+    spec->ranges = grown;
+    memcpy(spec->ranges + spec->count, more->ranges, more->count * sizeof(AddressRange));
+    spec->count += more->count;
+    normalize(spec);
+    return true;
+}
+
+static bool parse_entry(const char* entry, TargetSpec* spec) {
+    uint32_t network;
+    int prefix_len;
+    size_t len = strlen(entry);
+    if (len > 0 && entry[len - 1] == '.') {
+        // Legacy "a.b.c." form means the whole /24
+        char cidr[32];
+        if (len + 4 >= sizeof(cidr)) return false;
+        memcpy(cidr, entry, len);
+        memcpy(cidr + len, "0/24", 5);
+        if (!parse_cidr(cidr, &network, &prefix_len)) return false;
+    } else if (!parse_cidr(entry, &network, &prefix_len)) {
+        return false;
+    }
+    return target_spec_add_cidr(spec, network, prefix_len);
+}
+
+bool target_spec_parse(const char* text, TargetSpec* spec) {
+    memset(spec, 0, sizeof(*spec));
+    const char* p = text;
+    while (*p) {
+        char entry[64];
+        size_t n = 0;
+        while (*p && *p != ',') {
+            if (!isspace((unsigned char)*p)) {
+                if (n + 1 >= sizeof(entry)) {
+                    target_spec_free(spec);
+                    return false;
+                }
+                entry[n++] = *p;
+            }
+            p++;
+        }
+        entry[n] = '\0';
+        if (*p == ',') p++;
+        if (n == 0) continue;
+        if (!parse_entry(entry, spec)) {
+            target_spec_free(spec);
+            return false;
+        }
+    }
+    if (spec->count == 0) {
+        target_spec_free(spec);
+        return false;
+    }
+    return true;
+}
+
+uint32_t target_spec_addr_at(const TargetSpec* spec, uint64_t index) {
+    for (int i = 0; i < spec->count; i++) {
+        uint64_t size = (uint64_t)spec->ranges[i].last - spec->ranges[i].first + 1;
+        if (index < size) return spec->ranges[i].first + (uint32_t)index;
+        index -= size;
+    }
+    return 0;
+}
+
+bool target_spec_contains(const TargetSpec* spec, uint32_t addr) {
+    // Ranges are sorted and disjoint, so a binary search finds the only candidate
+    int low = 0, high = spec->count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (addr < spec->ranges[mid].first) high = mid - 1;
+        else if (addr > spec->ranges[mid].last) low = mid + 1;
+        else return true;
+    }
+    return false;
+}
+
+void target_spec_describe(const TargetSpec* spec, char* buffer, size_t buffer_size) {
+    if (spec->count == 0) {
+        snprintf(buffer, buffer_size, "(none)");
+        return;
+    }
+
+    // Report the first range as a CIDR block when it is one
+    const AddressRange* range = &spec->ranges[0];
+    uint32_t first = range->first, last = range->last;
+    int prefix_len = 32;
+    for (int p = 30; p >= TARGET_MIN_PREFIX; p--) {
+        uint32_t mask = 0xFFFFFFFFu << (32 - p);
+        uint32_t network = (first - 1) & mask;
+        if (network + 1 == first && (network | ~mask) - 1 == last) {
+            prefix_len = p;
+            first = network;
+            break;
+        }
+    }
+
+    char ip[16];
+    struct in_addr in;
+    in.s_addr = htonl(first);
+    inet_ntop(AF_INET, &in, ip, sizeof(ip));
+    int written;
+    if (prefix_len == 32 && range->first != range->last) {
+        char last_ip[16];
+        in.s_addr = htonl(range->last);
+        inet_ntop(AF_INET, &in, last_ip, sizeof(last_ip));
+        written = snprintf(buffer, buffer_size, "%s-%s", ip, last_ip);
+    } else {
+        written = snprintf(buffer, buffer_size, "%s/%d", ip, prefix_len);
+    }
+    if (spec->count > 1 && written > 0 && (size_t)written < buffer_size) {
+        snprintf(buffer + written, buffer_size - written, " +%d more", spec->count - 1);
+    }
+}
+
+void target_spec_free(TargetSpec* spec) {
+    free(spec->ranges);
+    spec->ranges = NULL;
+    spec->count = 0;
+    spec->total = 0;
+}
+
+bool port_list_parse(const char* text, PortList* list) {
+    list->count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end;
+        long port = strtol(p, &end, 10);
+        if (end == p || port < 1 || port > 65535 || (*end != ',' && *end != '\0')) return false;
+
+        bool duplicate = false;
+        for (int i = 0; i < list->count; i++) {
+            if (list->ports[i] == (uint16_t)port) duplicate = true;
+        }
+        if (!duplicate) {
+            if (list->count >= MAX_HOST_PORTS) return false;
+            list->ports[list->count++] = (uint16_t)port;
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return list->count > 0;
+}
+
+bool parse_cidr(const char* text, uint32_t* network, int* prefix_len) {
+    char addr_text[32];
+    const char* slash = strchr(text, '/');
+    size_t addr_len = slash ? (size_t)(slash - text) : strlen(text);
+    if (addr_len == 0 || addr_len >= sizeof(addr_text)) return false;
+    memcpy(addr_text, text, addr_len);
+    addr_text[addr_len] = '\0';
+
+    int prefix = 32;
+    if (slash) {
+        char* end;
+        long value = strtol(slash + 1, &end, 10);
+        if (end == slash + 1 || *end != '\0' || value < 0 || value > 32) return false;
+        prefix = (int)value;
+    }
+
+    struct in_addr addr;
+    if (inet_pton(AF_INET, addr_text, &addr) != 1) return false;
+    uint32_t mask = (prefix == 0) ? 0 : 0xFFFFFFFFu << (32 - prefix);
+    *network = ntohl(addr.s_addr) & mask;
+    *prefix_len = prefix;
+    return true;
+}
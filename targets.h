@@ -0,0 +1,74 @@
+#ifndef TARGETS_H
+#define TARGETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Scan Target Ranges ---
+// A scan is described by a list of IPv4 CIDR blocks (e.g. "10.0.0.0/20,10.8.0.0/24").
+// Blocks are stored as packed inclusive address ranges and addresses are
+// generated on demand, so a /16 costs a few bytes until it is probed.
+
+#define TARGET_MIN_PREFIX 8 // Refuse anything wider than a /8
+#define MAX_HOST_PORTS 16   // Longest port list a single host can be probed on
+
+typedef struct {
+    uint32_t first; // Host byte order, inclusive
+    uint32_t last;
+} AddressRange;
+
+typedef struct {
+    uint16_t ports[MAX_HOST_PORTS];
+    int count;
+} PortList;
+
+// Loops over a port list use PORT_LIST_COUNT. When the build profile fixes
+// the ports (NETMON_FIXED_PORTS) every list holds exactly those, so the trip
+// count is a constant and the compiler unrolls the loop.
+#ifdef NETMON_FIXED_PORTS
+#define FIXED_PORT_COUNT ((int)(sizeof((const uint16_t[]){NETMON_FIXED_PORTS}) / sizeof(uint16_t)))
+#define PORT_LIST_COUNT(list) FIXED_PORT_COUNT
+#else
+#define PORT_LIST_COUNT(list) ((list)->count)
+#endif
+
+typedef struct {
+    AddressRange* ranges; // Sorted and non-overlapping
+    int count;
+    uint64_t total;       // Number of addresses across all ranges
+} TargetSpec;
+
+// Parses a comma-separated list of CIDR blocks, bare addresses, or the legacy
+// "192.168.1." form (treated as a /24) into a fresh spec; whatever spec held
+// before is not freed. Returns false on any malformed entry.
+bool target_spec_parse(const char* text, TargetSpec* spec);
+
+// Adds every range of more to spec, merging any overlap.
+bool target_spec_append(TargetSpec* spec, const TargetSpec* more);
+
+// Adds network/prefix_len. Network and broadcast addresses are skipped for
+// prefixes up to /30, matching the old 1..254 host range of a /24. Ranges
+// reaching into 0.0.0.0/8 or 240.0.0.0/4 are refused with a message: those
+// ids name IPv6 and remote hosts (hostaddr.h).
+bool target_spec_add_cidr(TargetSpec* spec, uint32_t network, int prefix_len);
+
+// Returns the address at position index (0 <= index < spec->total).
+uint32_t target_spec_addr_at(const TargetSpec* spec, uint64_t index);
+
+// True when addr lies inside one of the ranges.
+bool target_spec_contains(const TargetSpec* spec, uint32_t addr);
+
+// Writes a short human-readable description such as "10.0.0.0/20 +1 more".
+void target_spec_describe(const TargetSpec* spec, char* buffer, size_t buffer_size);
+
+void target_spec_free(TargetSpec* spec);
+
+// Parses a comma-separated port list such as "22,443,3389". Duplicates are
+// dropped; returns false for an empty list, a bad port or too many ports.
+bool port_list_parse(const char* text, PortList* list);
+
+// Parses "a.b.c.d/len" (or a bare address as a /32) into a network and prefix.
+bool parse_cidr(const char* text, uint32_t* network, int* prefix_len);
+
+#endif
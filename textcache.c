@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "textcache.h"
+
+#define TEXT_CACHE_BUCKETS 4096 // Power of two, about twice the capacity
+
+typedef struct {
+    char* text;
+    uint32_t hash;
+    SDL_Color color;
+    SDL_Texture* texture;
+    int w, h;
+    uint64_t last_used;
+    int next; // Next entry in the same bucket, -1 at the end
+} TextCacheEntry;
+
+static TextCacheEntry entries[TEXT_CACHE_CAPACITY];
+static int entry_count = 0;
+static int buckets[TEXT_CACHE_BUCKETS];
+static bool buckets_ready = false;
+static uint64_t use_clock = 0;
+
+static uint32_t text_hash(const char* text, SDL_Color color) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    uint32_t rgba = ((uint32_t)color.r << 24) | ((uint32_t)color.g << 16) | ((uint32_t)color.b << 8) | color.a;
+    return (hash ^ rgba) * 16777619u;
+}
+
+static void unlink_entry(int index) {
+    int* link = &buckets[entries[index].hash & (TEXT_CACHE_BUCKETS - 1)];
+    while (*link != index) link = &entries[*link].next;
+    *link = entries[index].next;
+}
+
+// Picks a free entry, evicting the least recently used one when full.
+static int claim_entry(void) {
+    if (entry_count < TEXT_CACHE_CAPACITY) return entry_count++;
+
+    int victim = 0;
+    for (int i = 1; i < TEXT_CACHE_CAPACITY; i++) {
+        if (entries[i].last_used < entries[victim].last_used) victim = i;
+    }
+    unlink_entry(victim);
+    SDL_DestroyTexture(entries[victim].texture);
+    free(entries[victim].text);
+    return victim;
+}
+
+SDL_Texture* text_cache_get(SDL_Renderer* renderer, TTF_Font* font, const char* text, SDL_Color color, int* w, int* h) {
+    if (!text || !text[0]) return NULL; // SDL_ttf refuses zero-width text
+    if (!buckets_ready) {
+        memset(buckets, -1, sizeof(buckets));
+        buckets_ready = true;
+    }
+
+    uint32_t hash = text_hash(text, color);
+    int* bucket = &buckets[hash & (TEXT_CACHE_BUCKETS - 1)];
+    for (int i = *bucket; i >= 0; i = entries[i].next) {
+        TextCacheEntry* entry = &entries[i];
+        if (entry->hash == hash && memcmp(&entry->color, &color, sizeof(color)) == 0 && strcmp(entry->text, text) == 0) {
+            entry->last_used = ++use_clock;
+            *w = entry->w;
+            *h = entry->h;
+            return entry->texture;
+        }
+    }
+
+    SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
+    if (!surface) return NULL;
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    int surface_w = surface->w, surface_h = surface->h;
+    SDL_FreeSurface(surface);
+    char* text_copy = malloc(strlen(text) + 1);
+    if (!texture || !text_copy) {
+        if (texture) SDL_DestroyTexture(texture);
+        free(text_copy);
+        return NULL;
+    }
+    strcpy(text_copy, text);
+
+    int index = claim_entry();
+    TextCacheEntry* entry = &entries[index];
+    entry->text = text_copy;
+    entry->hash = hash;
+    entry->color = color;
+    entry->texture = texture;
+    entry->w = surface_w;
+    entry->h = surface_h;
+    entry->last_used = ++use_clock;
+    // Re-read the bucket head: eviction may have unlinked an entry from it
+    entry->next = *bucket;
+    *bucket = index;
+
+    *w = surface_w;
+    *h = surface_h;
+    return texture;
+}
+
+void text_cache_clear(void) {
+    for (int i = 0; i < entry_count; i++) {
+        SDL_DestroyTexture(entries[i].texture);
+        free(entries[i].text);
+    }
+    entry_count = 0;
+    memset(buckets, -1, sizeof(buckets));
+    buckets_ready = true;
+}
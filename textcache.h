@@ -0,0 +1,22 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// --- Text Texture Cache ---
+// Rasterizing a string with SDL_ttf and uploading it as a texture costs far
+// more than drawing it, so each (text, color) pair is rendered once and kept
+// as a texture. A string that changes (a new status, a resolved hostname)
+// simply becomes a new key; the old one ages out in least-recently-used order.
+
+#define TEXT_CACHE_CAPACITY 2048
+
+// Returns the cached texture for text in color, rendering it on a miss.
+// The texture stays owned by the cache. Returns NULL for empty text or on error.
+SDL_Texture* text_cache_get(SDL_Renderer* renderer, TTF_Font* font, const char* text, SDL_Color color, int* w, int* h);
+
+// Destroys every cached texture. Call before the renderer is destroyed.
+void text_cache_clear(void);
+
+#endif
@@ -0,0 +1,39 @@
+#define _GNU_SOURCE
+#include <time.h>
+#include <sys/time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "timeutil.h"
+
+uint64_t monotonic_us(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+uint64_t monotonic_ms(void) {
+    return monotonic_us() / 1000;
+}
+
+void wall_clock_deadline(uint64_t delay_ms, struct timespec* deadline) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    deadline->tv_sec = now.tv_sec + (time_t)(delay_ms / 1000);
+    deadline->tv_nsec = now.tv_usec * 1000 + (long)(delay_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef TIMEUTIL_H
+#define TIMEUTIL_H
+
+#include <stdint.h>
+#include <time.h>
+
+// --- Monotonic Clock ---
+// Unaffected by wall-clock changes; only differences between readings mean anything.
+
+uint64_t monotonic_ms(void);
+uint64_t monotonic_us(void);
+
+// --- Condition Variable Deadlines ---
+// pthread_cond_timedwait takes an absolute wall-clock time; this turns a
+// delay into one, just before waiting.
+void wall_clock_deadline(uint64_t delay_ms, struct timespec* deadline);
+
+#endif
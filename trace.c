@@ -0,0 +1,153 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+typedef struct {
+    uint64_t start_us;
+    uint32_t duration_us; // Clamped; no traced span comes near 71 minutes
+    uint16_t thread;
+    uint16_t metric;
+} TraceEvent;
+
+typedef struct {
+    uint64_t buckets[TRACE_BUCKETS];
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+} TraceHistogram;
+
+static const char* metric_names[TRACE_METRIC_COUNT] = {"lock_wait", "lock_hold", "frame", "sweep", "batch", "probe"};
+
+// All counters are updated with __atomic builtins; the recording path never
+// takes a lock, so tracing the host lock does not add contention to it.
+static TraceHistogram histograms[TRACE_METRIC_COUNT];
+static TraceEvent* events = NULL; // NULL unless --trace was given
+static unsigned int event_count = 0; // Slots claimed; may run past TRACE_MAX_EVENTS
+static const char* trace_path = NULL;
+static char thread_names[TRACE_MAX_THREADS][16];
+static int next_thread = 0;
+static __thread int thread_id = -1; // Per-thread slot, assigned on first use
+
+static int current_thread(void) {
+    if (thread_id < 0) thread_id = __atomic_fetch_add(&next_thread, 1, __ATOMIC_RELAXED);
+    return thread_id;
+}
+
+static int bucket_for(uint64_t duration_us) {
+    int bucket = 0;
+    while (bucket < TRACE_BUCKETS - 1 && (duration_us >> bucket) != 0) bucket++;
+    return bucket;
+}
+
+void trace_record(TraceMetric metric, uint64_t start_us, uint64_t duration_us) {
+    TraceHistogram* histogram = &histograms[metric];
+    __atomic_add_fetch(&histogram->buckets[bucket_for(duration_us)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->total_us, duration_us, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    while (duration_us > max && !__atomic_compare_exchange_n(&histogram->max_us, &max, duration_us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    // Single probes and uncontended lock waits would bury everything else in the file
+    if (!events || metric == TRACE_PROBE || (metric == TRACE_LOCK_WAIT && duration_us == 0)) return;
+    unsigned int slot = __atomic_fetch_add(&event_count, 1, __ATOMIC_RELAXED);
+    if (slot >= TRACE_MAX_EVENTS) return;
+    TraceEvent* event = &events[slot];
+    event->start_us = start_us;
+    event->duration_us = duration_us > UINT32_MAX ? UINT32_MAX : (uint32_t)duration_us;
+    event->thread = (uint16_t)current_thread();
+    event->metric = (uint16_t)metric;
+}
+
+void trace_name_thread(const char* name) {
+    int thread = current_thread();
+    if (thread >= TRACE_MAX_THREADS) return;
+    strncpy(thread_names[thread], name, sizeof(thread_names[thread]) - 1);
+}
+
+void trace_summarize(TraceMetric metric, TraceSummary* out) {
+    const TraceHistogram* histogram = &histograms[metric];
+    uint64_t buckets[TRACE_BUCKETS];
+    for (int b = 0; b < TRACE_BUCKETS; b++) buckets[b] = __atomic_load_n(&histogram->buckets[b], __ATOMIC_RELAXED);
+    out->count = __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    out->total_us = __atomic_load_n(&histogram->total_us, __ATOMIC_RELAXED);
+    out->max_us = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    out->p50_us = out->p99_us = 0;
+
+    uint64_t total = 0;
+    for (int b = 0; b < TRACE_BUCKETS; b++) total += buckets[b];
+    uint64_t p50_rank = (total + 1) / 2, p99_rank = (total * 99 + 99) / 100;
+    uint64_t seen = 0;
+    bool p50_found = false; // Bucket 0 is a real median of 0 us, common for lock waits
+    for (int b = 0; b < TRACE_BUCKETS && total > 0; b++) {
+        seen += buckets[b];
+        uint64_t upper = (b == 0) ? 0 : (1ull << b) - 1;
+        if (upper > out->max_us) upper = out->max_us; // The top bucket is never wider than what was seen
+        if (!p50_found && seen >= p50_rank) {
+            out->p50_us = upper;
+            p50_found = true;
+        }
+        if (seen >= p99_rank) {
+            out->p99_us = upper;
+            break;
+        }
+    }
+}
+
+const char* trace_metric_name(TraceMetric metric) {
+    return metric_names[metric];
+}
+
+bool trace_set_output(const char* path) {
+    events = malloc(TRACE_MAX_EVENTS * sizeof(TraceEvent));
+    if (!events) return false;
+    trace_path = path;
+    return true;
+}
+
+static bool write_trace_file(void) {
+    FILE* file = fopen(trace_path, "w");
+    if (!file) return false;
+    unsigned int count = __atomic_load_n(&event_count, __ATOMIC_RELAXED);
+    unsigned int kept = count < TRACE_MAX_EVENTS ? count : TRACE_MAX_EVENTS;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"netmonitor\"}}");
+    int threads = __atomic_load_n(&next_thread, __ATOMIC_RELAXED);
+    for (int t = 0; t < threads && t < TRACE_MAX_THREADS; t++) {
+        if (thread_names[t][0] == '\0') continue;
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", t, thread_names[t]);
+    }
+    for (unsigned int i = 0; i < kept; i++) {
+        const TraceEvent* event = &events[i];
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u}",
+                metric_names[event->metric], (unsigned int)event->thread, (unsigned long long)event->start_us, (unsigned int)event->duration_us);
+    }
+    fprintf(file, "\n]}\n");
+    bool written = fclose(file) == 0;
+    if (count > kept) printf("Trace buffer was full: %u spans dropped.\n", count - kept);
+    return written;
+}
+
+void trace_finish(void) {
+    printf("%-10s %10s %10s %10s %10s %12s\n", "trace", "count", "p50_us", "p99_us", "max_us", "total_us");
+    for (int m = 0; m < TRACE_METRIC_COUNT; m++) {
+        TraceSummary summary;
+        trace_summarize((TraceMetric)m, &summary);
+        printf("%-10s %10llu %10llu %10llu %10llu %12llu\n", metric_names[m], (unsigned long long)summary.count,
+               (unsigned long long)summary.p50_us, (unsigned long long)summary.p99_us, (unsigned long long)summary.max_us,
+               (unsigned long long)summary.total_us);
+    }
+
+    if (!events) return;
+    if (write_trace_file()) {
+        printf("Trace written to %s\n", trace_path);
+    } else {
+        printf("Could not write the trace to %s\n", trace_path);
+    }
+    free(events);
+    events = NULL;
+}
@@ -0,0 +1,79 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timeutil.h"
+
+// --- Hot-Path Instrumentation ---
+// Built only with -DNETMON_TRACE (make TRACE=1). Each metric keeps a log2
+// histogram of durations, and with --trace FILE every span except single
+// probes and uncontended lock waits is also kept for a Chrome trace /
+// Perfetto JSON file written at exit. Without NETMON_TRACE every call below
+// is an empty inline function and trace_now() is 0, so instrumented code
+// compiles to what it was.
+
+typedef enum {
+    TRACE_LOCK_WAIT, // host_list_lock() until the lock is held
+    TRACE_LOCK_HOLD, // Lock held until host_list_unlock()
+    TRACE_FRAME,     // One GUI frame, render and present
+    TRACE_SWEEP,     // One discovery sweep, neighbor seeding included
+    TRACE_BATCH,     // One monitoring batch, probing and publishing
+    TRACE_PROBE,     // One answered probe (histogram only)
+    TRACE_METRIC_COUNT
+} TraceMetric;
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t p50_us; // Upper bound of the histogram bucket
+    uint64_t p99_us;
+    uint64_t max_us;
+} TraceSummary;
+
+#ifdef NETMON_TRACE
+#define TRACE_BUCKETS 40 // Bucket b holds durations below 2^b microseconds
+#define TRACE_MAX_EVENTS (1 << 20) // Spans kept for the trace file; later ones are counted as dropped
+#define TRACE_MAX_THREADS 64 // Named threads in the trace file
+
+static inline uint64_t trace_now(void) {
+    return monotonic_us();
+}
+
+// Adds one span to the histogram of metric and, if a trace file was asked
+// for, to the trace. Safe from any thread.
+void trace_record(TraceMetric metric, uint64_t start_us, uint64_t duration_us);
+
+// Labels the calling thread in the trace file.
+void trace_name_thread(const char* name);
+
+void trace_summarize(TraceMetric metric, TraceSummary* out);
+const char* trace_metric_name(TraceMetric metric);
+
+// Keeps spans for path (--trace FILE). Returns false if the buffer cannot be allocated.
+bool trace_set_output(const char* path);
+
+// Prints every histogram and writes the trace file. Call once every traced
+// thread has stopped.
+void trace_finish(void);
+#else
+static inline uint64_t trace_now(void) {
+    return 0;
+}
+
+static inline void trace_record(TraceMetric metric, uint64_t start_us, uint64_t duration_us) {
+    (void)metric;
+    (void)start_us;
+    (void)duration_us;
+}
+
+static inline void trace_name_thread(const char* name) {
+    (void)name;
+}
+
+static inline void trace_finish(void) {
+}
+#endif
+
+#endif